@@ -0,0 +1,142 @@
+/**
+ * This file contains the compile time description of every axis. The axis settings in
+ * Configuration.h are kept in constexpr tables, and AxisConfig<axis> gives the settings of a single
+ * axis as constants along with the values derived from them (degrees per step, encoder ratio), so
+ * the compiler can fold them into the code that uses them. forEachAxis() unrolls a loop over the
+ * axes at compile time so the axis can be used as a template argument inside the loop.
+ *
+ * Motors built from a configuration that is only known at runtime use the normal Stepper
+ * constructor instead.
+ *
+ * @author Thomas Batchelder
+ * @file AxisConfig.h
+ * @date 10/17/2026 - File created
+ */
+
+#pragma once
+#include "Configuration.h"
+#include <type_traits>
+
+/**
+ * This function is used to get the first pin of an encoder from its pair of pins in Configuration.h
+ * @param pin1 is the first pin of the encoder
+ * @param pin2 is the second pin of the encoder
+ * @return is the first pin
+ */
+constexpr uint8_t firstEncoderPin(uint8_t pin1, uint8_t pin2) { return pin1; }
+
+constexpr uint8_t configStepPins[DOF] = STEP_PINS;
+constexpr uint8_t configDirPins[DOF] = DIR_PINS;
+constexpr uint8_t configLimitSwitchPins[DOF] = LIMIT_SWITCH_PINS;
+constexpr uint8_t configEncoderPins[DOF] = { firstEncoderPin(ENCODER_1_PINS), firstEncoderPin(ENCODER_2_PINS), firstEncoderPin(ENCODER_3_PINS),
+    firstEncoderPin(ENCODER_4_PINS), firstEncoderPin(ENCODER_5_PINS), firstEncoderPin(ENCODER_6_PINS) };
+constexpr int32_t configEncoderThreshold[DOF] = ENCODER_THRESHOLD;
+constexpr int32_t configMicrosteping[DOF] = MICROSTEPING;
+constexpr double configGearReduction[DOF] = GEAR_REDUCTION;
+constexpr int32_t configMaxPosition[DOF] = MAX_POSITION;
+constexpr int configInvertDir[DOF] = INVERT_DIR;
+constexpr int configCrashDetection[DOF] = CRASH_DETECTION;
+constexpr double configMaxVelocity[DOF] = MAX_AXIS_VELOCITY;
+constexpr double configMaxAcceleration[DOF] = MAX_AXIS_ACCELERATION;
+
+/**
+ * This function is used to find the greatest common divisor of two numbers
+ * @param a is the first number
+ * @param b is the second number
+ * @return is the greatest common divisor
+ */
+constexpr int32_t greatestCommonDivisor(int32_t a, int32_t b)
+{
+    return (b == 0) ? a : greatestCommonDivisor(b, a % b);
+}
+
+/**
+ * This function is used to find the angle an axis moves with each step
+ * @param microsteping is the number of microsteps in one rotation of the motor
+ * @param gearReduction is the gear reduction between the motor and the axis
+ * @return is the angle in degrees
+ */
+constexpr double degreesPerStep(int32_t microsteping, double gearReduction)
+{
+    return DEGREES_PER_ROTATION / (microsteping * gearReduction);
+}
+
+/**
+ * Encoder counts are turned into motor steps by multiplying by microsteping / ENCODER_CPR. The
+ * ratio is reduced so the product fits in the integer math used to scale the counts.
+ * @param microsteping is the number of microsteps in one rotation of the motor
+ * @return is the numerator of the reduced ratio
+ */
+constexpr int32_t encoderRatioNumerator(int32_t microsteping)
+{
+    return microsteping / greatestCommonDivisor(microsteping, (int32_t)ENCODER_CPR);
+}
+
+/**
+ * This function is used to get the denominator of the reduced microsteping / ENCODER_CPR ratio
+ * @param microsteping is the number of microsteps in one rotation of the motor
+ * @return is the denominator of the reduced ratio
+ */
+constexpr int32_t encoderRatioDenominator(int32_t microsteping)
+{
+    return (int32_t)ENCODER_CPR / greatestCommonDivisor(microsteping, (int32_t)ENCODER_CPR);
+}
+
+/**
+ * Compile time description of a single axis from Configuration.h
+ */
+template <int axisIndex>
+struct AxisConfig {
+    static_assert(axisIndex >= 0 && axisIndex < DOF, "The axis has to be between 0 and DOF - 1");
+
+    static constexpr int axis = axisIndex;
+    static constexpr uint8_t stepPin = configStepPins[axisIndex];
+    static constexpr uint8_t dirPin = configDirPins[axisIndex];
+    static constexpr uint8_t limPin = configLimitSwitchPins[axisIndex];
+    static constexpr uint8_t encoderPin = configEncoderPins[axisIndex];
+    static constexpr int32_t encoderThreshold = configEncoderThreshold[axisIndex];
+    static constexpr int32_t microsteping = configMicrosteping[axisIndex];
+    static constexpr double gearReduction = configGearReduction[axisIndex];
+    static constexpr int32_t maxPosition = configMaxPosition[axisIndex];
+    static constexpr bool invertDir = configInvertDir[axisIndex] != 0;
+    static constexpr bool crashDetection = configCrashDetection[axisIndex] != 0;
+    static constexpr double maxVelocity = configMaxVelocity[axisIndex];
+    static constexpr double maxAcceleration = configMaxAcceleration[axisIndex];
+
+    static constexpr double degreeChangePerStep = degreesPerStep(microsteping, gearReduction);
+    static constexpr int32_t stepsNumerator = encoderRatioNumerator(microsteping);
+    static constexpr int32_t stepsDenominator = encoderRatioDenominator(microsteping);
+
+    static_assert(maxVelocity * STEP_MIN_INTERVAL_MICROSECONDS <= degreeChangePerStep,
+        "The velocity limit of the axis needs steps closer together than STEP_MIN_INTERVAL_MICROSECONDS");
+};
+
+/**
+ * This function is used to get the mask of the axes whose direction pin is inverted, the direction
+ * pin of an axis is high while it moves counterclockwise unless the axis is in the mask
+ * @return has bit i set if the direction of axis i + 1 is inverted
+ */
+template <int axis = 0>
+constexpr typename std::enable_if<(axis >= DOF), uint8_t>::type directionInvertMask() { return 0; }
+
+template <int axis = 0>
+constexpr typename std::enable_if<(axis < DOF), uint8_t>::type directionInvertMask()
+{
+    return (AxisConfig<axis>::invertDir ? 1 << axis : 0) | directionInvertMask<axis + 1>();
+}
+
+/**
+ * This function is used to run a function for each axis with the loop unrolled at compile time.
+ * The function is given a std::integral_constant holding the axis, so decltype(axis)::value can
+ * be used as a template argument.
+ * @param function is the function run for each axis
+ */
+template <int count, int axis = 0, class Function>
+inline typename std::enable_if<(axis < count)>::type forEachAxis(Function&& function)
+{
+    function(std::integral_constant<int, axis>());
+    forEachAxis<count, axis + 1>(function);
+}
+
+template <int count, int axis = 0, class Function>
+inline typename std::enable_if<(axis >= count)>::type forEachAxis(Function&& function) { }
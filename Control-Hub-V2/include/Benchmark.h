@@ -0,0 +1,61 @@
+/**
+ * This file is responsible for benchmarking the step pipeline. Synthetic moves are sent through
+ * the event queue while every interrupt of the step engine is recorded, and the results are
+ * printed as one JSON object per line so they can be collected and compared between releases.
+ * The benchmarks are only built when RUN_BENCHMARKS is defined ([env:teensy41_bench] and
+ * [env:native_bench]).
+ *
+ * @author Thomas Batchelder
+ * @file Benchmark.h
+ * @date 10/17/2026 - File created
+ */
+
+#pragma once
+#include "Controller.h"
+#include "Hal.h"
+#include "StepRecorder.h"
+
+/** Results of a single benchmark move */
+struct BenchmarkResult {
+    /** Number of step engine interrupts recorded */
+    uint32_t edges;
+    /** Number of steps sent across all axes */
+    uint32_t steps;
+    /** Number of interrupts that did not fit in the recorder */
+    uint32_t droppedEdges;
+    /** Step rate of the dominant axis while cruising in Hz */
+    double cruiseRate;
+    /** Percentiles of the difference between the actual and planned time between interrupts in microseconds */
+    double jitterP50, jitterP90, jitterP99, jitterMax;
+    /** Number of interrupts that came later than planned by more than the tolerance */
+    uint32_t missedDeadlines;
+    /** Average and longest time taken by one run of the main loop in microseconds (measured with the cycle counter) */
+    double loopMean, loopMax;
+};
+
+/** Movement sent in the frames of the serial load benchmark */
+struct SerialLoad {
+    /** Position the benchmark move ends at in degrees */
+    double targetPosition[DOF];
+    /** Velocity and acceleration of the benchmark move */
+    double velocity, acceleration;
+};
+
+/**
+ * This function is used to run every benchmark and print the results to the serial port.
+ * Crash detection is turned off while the benchmarks run since the motors do not have to be
+ * connected, it is restored afterwards.
+ *
+ * Each line printed is a JSON object with a "benchmark" field:
+ *  - "info" describes the platform and the timestamp source
+ *  - "profile_evaluation" compares the cost of working out each segment of a movement by evaluating
+ *    the profile (what the event queue does) against advancing it with Q32.32 forward differences.
+ *    The forward differences are only a candidate measured here, the event queue does not use them
+ *  - "single_axis", "all_axes" and "serial_load" hold the results of one move
+ *  - "serial_load_start" and "serial_load_stop" are printed around each serial load move. In between
+ *    the computer sends frames holding a movement to "target_deg" and a queue status request, so the
+ *    frames are decoded, checked and answered while the arm steps (see runBenchmarks() in Controller.py)
+ *  - "summary" holds the highest step rate each case sustained without a missed deadline
+ * @param controller is the controller of the arm
+ */
+void runBenchmarks(Controller* controller);
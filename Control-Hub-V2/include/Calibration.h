@@ -6,8 +6,9 @@
  * @date 1/24/2021 - file created
  */
 
+#pragma once
 #include "Controller.h"
-#include <Arduino.h>
+#include "Hal.h"
 
 /**
  * This function is used to home all of the active axis
@@ -6,29 +6,214 @@
  * @date 1/30/2021 - file created
  */
 
+#pragma once
 #include "EventQueue.h"
+#include "Framing.h"
+#include "Telemetry.h"
 #include <Configuration.h>
 
-#define INIT_STATE 0
-#define MOVEMENT_INPUT 1
-#define END_TRANSMISSION -1
+/** Sent in place of an event code to request the state of the event queue */
+#define QUEUE_STATUS_REQUEST 4
+/** Sent in place of an event code to add a setpoint to the stream */
+#define STREAM_SETPOINT 6
+/** Sent in place of an event code to set the number of telemetry frames sent each second */
+#define TELEMETRY_RATE_REQUEST 7
+
+/** Size in bytes of the sequence number (uint16) at the start of each decoded frame */
+#define FRAME_SEQUENCE_SIZE 2
+
+/** Size in bytes of each reply frame before the CRC, all values are little endian */
+#define ACK_REPLY_SIZE 9 // type, uint16 sequence, uint16 records accepted, uint16 records rejected, uint16 credits
+#define NACK_REPLY_SIZE 5 // type, uint16 expected sequence, uint16 credits
+#define CREDIT_REPLY_SIZE 5 // type, uint16 expected sequence, uint16 credits
+
+/** Size in bytes of each record (including its code), all values are little endian */
+#define MOVEMENT_RECORD_SIZE 38 // code, 6 float32 target angles, float32 velocity, acceleration, jerk, uint8 flags
+#define SLEEP_RECORD_SIZE 5 // code, uint32 sleep time in microseconds
+#define HOMING_RECORD_SIZE 9 // code, float32 velocity, acceleration
+#define QUEUE_STATUS_RECORD_SIZE 1 // code
+#define STREAM_RECORD_SIZE 6 // code, uint32 playback delay in microseconds, uint8 interpolation
+#define SETPOINT_RECORD_SIZE 30 // code, uint32 timestamp in microseconds, 6 float32 angles, uint8 flags
+#define TELEMETRY_RATE_RECORD_SIZE 3 // code, uint16 frames each second (0 is off)
+
+/** Flags of a movement record */
+#define MOVEMENT_USE_ENCODER_POSITION 0x01
+
+static_assert(MOVEMENT_RECORD_SIZE == 1 + (DOF + 3) * sizeof(float) + 1, "The movement record holds the code, the float32 values and the flags");
+static_assert(MOVEMENT_RECORD_SIZE >= SLEEP_RECORD_SIZE && MOVEMENT_RECORD_SIZE >= HOMING_RECORD_SIZE && MOVEMENT_RECORD_SIZE >= STREAM_RECORD_SIZE,
+    "The values of every event record fit in the values of a movement record");
+static_assert(offsetof(Setpoint, flags) == SETPOINT_RECORD_SIZE - 2, "The values of a setpoint record are decoded into its slot");
+static_assert(ACK_REPLY_SIZE >= NACK_REPLY_SIZE && ACK_REPLY_SIZE >= CREDIT_REPLY_SIZE, "Every reply is encoded in the space of an ack");
+
+/** State of a frame while it is being decoded */
+struct FrameState {
+    /** Number of bytes decoded so far */
+    uint32_t length;
+    /** CRC of the bytes before the last two, which could be the CRC of the frame */
+    uint16_t crc;
+    /** Last two decoded bytes */
+    uint8_t lastBytes[FRAME_CRC_SIZE];
+    /** Sequence number of the frame */
+    uint16_t sequence;
+    /** Code and size of the record being decoded, and the number of its bytes decoded so far (0 between records) */
+    uint8_t recordCode;
+    uint32_t recordSize, recordIndex;
+    /** Slot the event or the setpoint of the record is filled into, NULL if the record is not being used */
+    EventNode* slot;
+    Setpoint* setpoint;
+    /** Where the values of the record are decoded, NULL if the record is not being used */
+    uint8_t* values;
+    /**
+     * Values of an event record. The queue stores less than a record holds (the target angles become
+     * steps), so the values are decoded here and then filled into the slot of the event.
+     */
+    uint8_t eventValues[MOVEMENT_RECORD_SIZE - 1];
+    /** Number of slots filled with events and with setpoints of the frame */
+    uint32_t reservedEvents, reservedSetpoints;
+    /** Number of records used and rejected by the queue */
+    uint32_t accepted, rejected;
+    /** Used to determine if the frame is well formed so far */
+    bool isValid;
+    /** Used to determine if the frame is the next frame in sequence, only its records are decoded */
+    bool isExpected;
+    /** Used to determine if the frame holds more events than there are free slots */
+    bool isOverCredit;
+    /** Used to determine if the frame asked for the state of the queue */
+    bool statusRequested;
+    /** Telemetry rate the frame asked for, and used to determine if it asked for one */
+    uint16_t telemetryRate;
+    bool telemetryRateRequested;
+};
 
 /**
- * This class is used to communcate between a computer and the Teensy microcontroller
+ * This class is used to communcate between a computer and the Teensy microcontroller.
+ * The computer sends frames (see Framing.h), each starting with a sequence number that goes up by
+ * one for every frame followed by any number of records. A record starts with its code
+ * (MOVEMENT_EVENT, SLEEP_EVENT, HOMING_EVENT, STREAM_EVENT, STREAM_SETPOINT, QUEUE_STATUS_REQUEST or
+ * TELEMETRY_RATE_REQUEST) followed by its values. Setpoints go to the stream rather than the event
+ * queue, so they do not use credits. A setpoint that arrives while the stream is full is counted as
+ * rejected instead of the frame being sent again, since it would be stale by the time it arrived.
+ *
+ * Flow control uses credits: each reply advertises the number of free slots in the event queue,
+ * and the computer only sends events that fit in the credits it has been given, less the events
+ * in frames that have not been answered yet. It can send several frames without waiting for each
+ * reply. The replies are frames (see Framing.h), sent between the telemetry frames (see Telemetry.h):
+ *  - FRAME_ACK with the sequence, the records accepted and rejected and the credits when a frame is
+ *    used (a frame that was already used is answered again with 0 0)
+ *  - FRAME_NACK with the expected sequence and the credits when a frame is dropped, since it was
+ *    damaged, came out of order or held more events than there are free slots. The computer sends
+ *    every frame from the expected sequence again, later frames that arrive out of order are dropped
+ *    without a reply.
+ *  - FRAME_CREDIT with the expected sequence and the credits when COMMUNICATION_CREDIT_UPDATE slots
+ *    have freed up since the last reply
  */
 class Communication {
 private:
-    /** Array for storing input data */
-    double data[20];
-    /** Counter used for counting input data */
-    long counter;
-    /** The currect state of communication */
-    int state;
+    /**
+     * Bytes received from the computer that have not been decoded. A frame is only decoded once its
+     * delimiter is in the ring, and its events are filled straight into reserved slots of the queue.
+     */
+    SpscRing<uint8_t, COMMUNICATION_RX_BUFFER_SIZE> received;
+    /** Number of frame delimiters in the received bytes */
+    uint32_t receivedFrames;
+    /** Used to determine if the frame being received is longer than the ring and is dropped up to its delimiter */
+    bool frameOverflow;
+    /** Number of frames that were dropped since they were too long, failed the CRC or held an incomplete record */
+    uint32_t frameErrors;
+    /** Sequence number of the next frame that will be used */
+    uint16_t expectedSequence;
+    /** Used to determine if a Nack has been sent for the expected frame, so frames after it are dropped quietly */
+    bool nackSent;
+    /** Number of free event queue slots in the last reply */
+    uint32_t advertisedCredits;
     /** Pointer to the EventQueue being used by the controller */
     EventQueue* eventQueue;
+    /** Pointer to the telemetry sender being used by the controller */
+    Telemetry* telemetry;
+
+    /**
+     * This function is used to decode the oldest received frame. Its events are only added to the
+     * queue once the whole frame has been checked, otherwise the reserved slots are left unused.
+     */
+    void processFrame();
+
+    /**
+     * This function is used to handle a decoded byte of a frame
+     * @param value is the decoded byte
+     * @param state is the state of the frame
+     */
+    void decodeByte(uint8_t value, FrameState* state);
+
+    /**
+     * This function is used to handle a byte of the records of a frame
+     * @param value is the byte
+     * @param state is the state of the frame
+     */
+    void decodeRecordByte(uint8_t value, FrameState* state);
+
+    /**
+     * This function is used to fill in the event of a record whose values have been decoded
+     * @param code is the code of the record
+     * @param values are the values of the record
+     * @param slot is the slot the event is filled into
+     * @return is false if the event was rejected by the queue, otherwise true is returned
+     */
+    bool decodeEvent(uint8_t code, uint8_t* values, EventNode* slot);
+
+    /**
+     * This function is used to get the size of a record
+     * @param code is the code the record starts with
+     * @return is the size of the record in bytes, 0 if the code is unknown
+     */
+    static uint32_t getRecordSize(uint8_t code);
+
+    /**
+     * This function is used to get the number of events that can still be added to the queue
+     * @return is the number of free slots in the event queue
+     */
+    uint32_t getCredits();
+
+    /**
+     * This function is used to tell the computer a frame was used
+     * @param sequence is the sequence number of the frame
+     * @param accepted is the number of records used
+     * @param rejected is the number of records rejected
+     * @param credits is the number of free slots in the event queue
+     */
+    void sendAck(uint16_t sequence, uint16_t accepted, uint16_t rejected, uint16_t credits);
+
+    /**
+     * This function is used to drop a frame and ask the computer to send it again
+     * @param isFrameError is true if the frame was damaged, which is counted as a frame error
+     */
+    void sendNack(bool isFrameError);
+
+    /**
+     * This function is used to send a reply to the computer. Replies are written straight away rather
+     * than through the telemetry ring, so a reply is never dropped.
+     * @param type is the type of the reply (FRAME_ACK, FRAME_NACK or FRAME_CREDIT)
+     * @param values are the values of the reply (uint16)
+     * @param count is the number of values
+     */
+    void sendReply(uint8_t type, const uint16_t* values, uint32_t count);
 
 public:
     Communication() {}
-    Communication(EventQueue* eventQueue);
+    Communication(EventQueue* eventQueue, Telemetry* telemetry);
+
+    /** This function is used to read the bytes sent by the computer and process every complete frame */
     void update();
+
+    /**
+     * This function is used to send the state of the event queue to the computer as a single line:
+     * "Queue Status: <depth> <capacity> <high water mark> <rejected events> <bytes used by the queue>
+     * <plan cache hits> <plan cache misses> <frame errors> <buffered setpoints> <stream underruns>"
+     */
+    void reportQueueStatus();
+
+    /**
+     * Used to get the number of frames from the computer that were dropped since they were damaged
+     * @return is the number of frame errors
+     */
+    uint32_t getFrameErrors();
 };
@@ -6,15 +6,17 @@
  */
 
 #pragma once
-#include <Arduino.h>
+#include "Hal.h"
 
 #define BAUDRATE 250000 // Serial monitor baud rate
 #define STARTUP_DELAY 7500 // Delay at beginning of program to let Serial monitor initialize
+#define COMMUNICATION_RX_BUFFER_SIZE 1024 // Bytes from the computer that can wait to be decoded, also the longest frame (must be a power of two)
+#define COMMUNICATION_CREDIT_UPDATE 8 // Number of event queue slots that have to free up before they are advertised unasked
 
 #define UNLIMITED_ROTATIONS -1 // Used to indicate that a motor is not limited
 #define CLOCKWISE false // Used to set the direction of the motor to reverse
 #define COUNTERCLOCKWISE true // Used to set the direction of the motor to forward
-#define MAX_VELOCITY 1e-2 // Maximum velocity the arm can travel at
+#define MAX_VELOCITY 1e-2 // Maximum velocity that can be requested for a movement (each axis is also limited below)
 
 #define MAX_STEPPER_ENCODER_DIFFERENCE 500 // number of steps that the encoder and stepper can differ
 #define ENCODER_CPR 4000.0 // Number of counts per revolution of the encoder
@@ -30,6 +32,51 @@
 #define HOMING_VELOCITY 0.04e-3
 #define HOMING_ACCELERATION 0.03e-9
 
+// Limit switch sampling configuration
+#define LIMIT_SWITCH_SAMPLE_MICROSECONDS 100 // Time between each reading of the limit switches
+#define LIMIT_SWITCH_SAMPLES 16 // Number of readings kept for each switch (at most 16)
+#define LIMIT_SWITCH_PRESS_RATIO 0.75 // Ratio of pressed readings needed to report a switch as pressed
+#define LIMIT_SWITCH_RELEASE_RATIO 0.25 // Ratio of pressed readings at which a switch is reported as released
+
+// Step engine configuration
+#define STEP_TICK_MICROSECONDS 25 // Period of the step interrupt while the engine waits for a segment
+#define STEP_MIN_INTERVAL_MICROSECONDS 10 // Shortest time allowed between two steps of the dominant axis
+#define STEP_PULSE_MICROSECONDS 3 // Time the step pins are held high for each step
+#define STEP_SEGMENT_MICROSECONDS 1000 // Length of each block of steps handed to the step engine
+#define STEP_SEGMENT_BUFFER_SIZE 16 // Number of segments the step engine can hold ahead of execution
+
+// Event queue configuration
+#define EVENT_QUEUE_SIZE 128 // Number of events the queue can hold (must be a power of two)
+#define JUNCTION_DEVIATION 0.05 // Distance in degrees the path may deviate from a corner between two movements
+#define S_CURVE_SEARCH_ITERATIONS 24 // Number of halving steps used to find the velocities of an S-curve profile
+#define PLAN_CACHE_SIZE 16 // Number of planned movements kept so that repeated movements are not planned again
+#define LOOK_AHEAD_PROFILES 16 // Number of queued movements whose profile is worked out ahead of time (must be a power of two)
+
+// Setpoint stream configuration
+#define STREAM_BUFFER_SIZE 128 // Number of setpoints that can wait to be played, bounds the playback delay (must be a power of two)
+#define STREAM_LEAD_SEGMENTS 2 // Most segments of a stream handed to the step engine ahead of time, keeps the latency low
+#define STREAM_TIMEOUT_MICROSECONDS 500000 // A stream that waits this long for setpoints is ended
+#define STREAM_DRIFT_SEGMENTS 256 // The playback delay is kept by moving the stream time by its error over this many segments (clock drift)
+#define STREAM_MAX_DRIFT_MICROSECONDS 10 // Most the stream time is moved in one segment to keep the playback delay
+
+// Telemetry configuration
+#define TELEMETRY_RATE 0 // Telemetry frames sent each second until the computer asks for another rate (0 is off)
+#define TELEMETRY_MAX_RATE 1000 // Highest telemetry rate the computer can ask for
+#define TELEMETRY_TX_BUFFER_SIZE 512 // Bytes of telemetry frames that can wait for room in the serial port (must be a power of two)
+
+// Crash recovery configuration
+#define CRASH_RECOVERY_SETTLE_MICROSECONDS 1000000 // Time the arm is left to settle after stopping before the encoders are read
+#define CRASH_RECOVERY_MIN_VELOCITY 0.1e-4 // The velocity of a crashed movement is only halved while it stays above this
+
+// Benchmark configuration (only used when built with RUN_BENCHMARKS)
+#define BENCHMARK_MAX_STEP_EDGES 8192 // Number of step engine interrupts the step recorder can hold
+#define BENCHMARK_MOVE_STEPS 4000 // Number of steps each axis takes in a benchmark move
+#define BENCHMARK_STEP_RATES {5000, 10000, 20000, 40000, 80000, 100000} // Step rates tested in Hz
+#define BENCHMARK_DEADLINE_TOLERANCE_MICROSECONDS 5 // Lateness after which a step counts as a missed deadline
+#define BENCHMARK_SERIAL_FRAME_MICROSECONDS 2000 // Time between the frames sent during the serial load benchmark (computer builds)
+#define BENCHMARK_SERIAL_QUIET_MICROSECONDS 200000 // Time without received bytes after which the computer has stopped sending frames
+#define BENCHMARK_HOST_LOOP_MICROSECONDS 5 // Time the virtual clock moves for each main loop (computer builds)
+
 // Axis Pins:               1   2   3   4   5   6
 #define STEP_PINS         { 3,  9,  1,  6, 24, 32}
 #define DIR_PINS          { 5, 11,  0,  8, 26, 31}
@@ -42,6 +89,10 @@
 #define INVERT_DIR        {1, 1, 1, 1, 1, 1}
 #define CRASH_DETECTION   {1, 1, 1, 1, 1, 1}
 
+// Motion limits of each axis, movements are slowed down so that no axis goes past them (0 is no limit)
+#define MAX_AXIS_VELOCITY     {0.5e-3, 0.5e-3, 0.5e-3, 0.5e-3, 1.5e-3, 1.5e-3} // degrees per microsecond
+#define MAX_AXIS_ACCELERATION {1.0e-10, 1.0e-10, 1.0e-10, 3.0e-10, 3.0e-10, 3.0e-10} // degrees per microsecond squared
+
 #define ENCODER_1_PINS    39, 7
 #define ENCODER_2_PINS    40, 25
 #define ENCODER_3_PINS     2, 41
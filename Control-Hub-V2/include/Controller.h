@@ -6,12 +6,14 @@
  * @date 1/19/2021 - File created
  */
 
+#pragma once
 #include "../include/Communication.h"
 #include "../include/Configuration.h"
+#include "../include/LimitSwitchSampler.h"
 #include "../include/Stepper.h"
+#include "../include/Telemetry.h"
 #include "../include/Util.h"
-#include <Arduino.h>
-#include <Encoder.h>
+#include "../include/Hal.h"
 
 /**
  * This class is responsible for controlling everything in the robot
@@ -22,10 +24,14 @@ protected:
     Stepper motors[DOF];
     /** Array containing pointers to all of the encoders */
     Encoder* encoders[DOF];
+    /** Samples and debounces the limit switches in the background */
+    LimitSwitchSampler limitSwitches;
     /** Event queue used to manage events */
     EventQueue eventQueue = EventQueue();
     /** Object used for communicating over Serial */
     Communication communication = Communication();
+    /** Sends the state of the arm to the computer at a fixed rate */
+    Telemetry telemetry = Telemetry();
     /** Motor Encoder for axis 1 */
     Encoder motorEncoder1 = Encoder(ENCODER_1_PINS);
     /** Motor Encoder for axis 2 */
@@ -54,7 +60,6 @@ public:
      * @param targetPosition is target position for the arm
      * @param velocity is the max velocity of the movement
      * @param acceleration is the acceleration/deceleration of the movement
-     * @param initVelocity is the starting velocity of the movement
      * @param useEncoderPosition is used to determine if the movement will use encoder positioning
      * or motor positioning
      * @param blocking is used to determine if the movement will be performed by blocking other
@@ -64,8 +69,6 @@ public:
         double* targetPosition,
         double velocity,
         double acceleration,
-        double initVelocity,
-        double finalVelocity,
         bool useEncoderPosition,
         bool blocking);
 
@@ -74,6 +77,12 @@ public:
      */
     void savePosition();
 
+    /**
+     * This function is used to read all of the encoders at once
+     * @param snapshot is where the encoder readings are stored
+     */
+    void snapshotEncoders(EncoderSnapshot* snapshot);
+
     /**
      * This function is used to get the array of steppers to be used by other classes
      * @return is a pointer to an array of steppers
@@ -86,12 +95,24 @@ public:
      */
     Encoder* getEncoders();
 
+    /**
+     * This function is used to get the limit switch sampler
+     * @return is the limit switch sampler
+     */
+    LimitSwitchSampler* getLimitSwitches();
+
     /**
      * This function is used to get the eventQueue
      * @return is the event queue
      */
     EventQueue* getEventQueue();
 
+    /**
+     * This function is used to get the communication with the computer
+     * @return is the communication
+     */
+    Communication* getCommunication();
+
     /** 
      * Used to determine if the robot is currently moving.
      * @return is true of the robot is moving, otherwise false is returned
@@ -8,62 +8,250 @@
  * @date 1/19/2021 - File created
  */
 
+#pragma once
 #include "Configuration.h"
+#include "PlanCache.h"
+#include "SpscRing.h"
+#include "StepEngine.h"
 #include "Stepper.h"
-#include <Arduino.h>
+#include "Hal.h"
 
 /** All event codes */
 #define MOVEMENT_EVENT 1
 #define SLEEP_EVENT 2
 #define HOMING_EVENT 3
+#define STREAM_EVENT 5
+
+/** Fixed point (Q32.32) value of a whole movement */
+#define MOVEMENT_FRACTION_ONE (1ll << 32)
 
 /** All Error codes */
 #define OUTSIDE_OF_MOTOR_BOUNDS 1
 #define VELOCITY_TOO_HIGH 2
+#define EVENT_QUEUE_FULL 3
+#define INVALID_JERK 4
+#define INVALID_INTERPOLATION 5
+
+/** Crash recovery states */
+#define RECOVERY_NONE 0
+#define RECOVERY_DECELERATING 1
+#define RECOVERY_SETTLING 2
+
+/** Interpolation used between the setpoints of a stream */
+#define STREAM_LINEAR 0
+#define STREAM_CUBIC 1
+
+/** Stream states */
+#define STREAM_NONE 0
+#define STREAM_STARTING 1
+#define STREAM_BUFFERING 2
+#define STREAM_PLAYING 3
+#define STREAM_FINISHED 4
+
+/** Flags of a setpoint */
+#define SETPOINT_END_OF_STREAM 0x01
+
+static_assert(STREAM_LEAD_SEGMENTS < STEP_SEGMENT_BUFFER_SIZE, "The segments of a stream have to fit in the step engine's buffer");
+static_assert(LOOK_AHEAD_PROFILES > 0 && (LOOK_AHEAD_PROFILES & (LOOK_AHEAD_PROFILES - 1)) == 0 && LOOK_AHEAD_PROFILES <= EVENT_QUEUE_SIZE,
+    "Each event at the front of the queue needs its own entry of the profile table");
+
+/**
+ * Trajectory of a movement or homing event. It is worked out by the look-ahead planner while the
+ * event waits near the front of the queue, so starting the event only has to copy it. Profiles are
+ * kept in a small table beside the queue rather than in each event.
+ */
+struct MovementProfile {
+    double tap, // Point in time when the movement stops accelerating
+        lap, // Variable used in movement calculations for constant velocity
+        lcsp, // Variable used in movement calculations for deceleration
+        tcsp, // Point in time when the movement start decelerating
+        tfin, // Point in time when the movement has finished
+        velocity, // peak velocity of the movement
+        acceleration, // acceleration/deceleration of the movement
+        initVelocity, // initial velocity of the movement
+        finalVelocity, // final velocity of the movement
+        largestDegreeChange, // largest degree change of all of the active axises
+        fractionPerDegree, // Used to turn the scaler (degrees) into a fixed point fraction of the movement
+        jerk, // rate of change of the acceleration, 0 for a trapezoid profile
+        accelerationJerkTime, // Time spent changing the acceleration at each end of the acceleration phase (S-curve)
+        decelerationJerkTime; // Time spent changing the acceleration at each end of the deceleration phase (S-curve)
+    /** Number of steps each axis travels during the movement */
+    uint32_t stepChange[DOF];
+    /** Axes that move counterclockwise during the movement (bit i is axis i) */
+    uint8_t directionMask;
+};
+
+/** Entry of the profile table, the velocities chosen by the look-ahead planner and the profile worked out from them */
+struct PlannedMovement {
+    /** Initial and final velocity of the movement in degrees per microsecond */
+    float initVelocity, finalVelocity;
+    /** Trajectory of the movement (an S-curve profile also keeps its jerk times here) */
+    MovementProfile profile;
+};
+
+/** Information needed by a movement or homing event */
+struct MovementEvent {
+    /** Position each axis moves to in steps (worked out when the event is added) */
+    int32_t targetSteps[DOF];
+    /** Peak velocity of the movement in degrees per microsecond */
+    float velocity;
+    /** Acceleration/deceleration of the movement in degrees per microsecond squared */
+    float acceleration;
+    /** Jerk of the movement in degrees per microsecond cubed, 0 for a trapezoid profile */
+    float jerk;
+};
+
+/** Information needed by a sleep event */
+struct SleepEvent {
+    /** Amount of time the event sleeps for in microseconds */
+    uint32_t sleepTime;
+};
+
+/** Information needed by a stream event */
+struct StreamEvent {
+    /**
+     * Time the stream is played behind the newest setpoint in microseconds. Setpoints can arrive late
+     * by up to this delay without the stream running out (jitter buffer).
+     */
+    uint32_t playbackDelay;
+    /** Interpolation used between the setpoints (STREAM_LINEAR or STREAM_CUBIC) */
+    uint8_t interpolation;
+};
+
+/**
+ * A point of a stream as it is sent by the computer. The setpoints are kept in their own ring
+ * rather than the event queue, so a dense stream does not fill the queue.
+ */
+struct Setpoint {
+    /** Point in time of the setpoint on the computer's clock in microseconds (it is allowed to wrap) */
+    uint32_t timestamp;
+    /** Angle of each axis in degrees */
+    float position[DOF];
+    /** Flags of the setpoint (SETPOINT_END_OF_STREAM) */
+    uint8_t flags;
+};
+
+/** A setpoint of the stream being played, with its position in steps */
+struct StreamPoint {
+    /** Point in time of the setpoint on the computer's clock in microseconds */
+    uint32_t time;
+    /** Position of each axis in steps (not rounded, so the interpolation stays smooth) */
+    double steps[DOF];
+    /** Used to determine if the setpoint is the last of the stream */
+    bool isEnd;
+};
 
+/**
+ * An event in the queue. Only the information used by the type of the event is stored, so a
+ * node holds the largest payload (a movement) rather than every field of every event. The nodes
+ * are packed rather than padded to a cache line since the queue lives in DTCM, which is not cached.
+ */
 struct EventNode {
-    /** This is the next node is the queue */
-    EventNode* nextEvent;
     /** This is the code that is associated with this event */
     uint8_t eventCode;
-    /** Variable to store the point in time when the event was created */
-    uint32_t timeVariable;
-    /** This is the degrees that each axis needs to travel to complete the event */
-    double targetPosition[DOF];
-    /** This contains the velocity, acceleration, initial velocity, and final velocity of the event */
-    double kinematicInfo[4];
     /** Determines if the movement should encoder position or motor position */
     bool useEncoderPosition;
+    /** Used to determine if the velocities and the profile of a movement or homing event have been worked out (see plannedMovements) */
+    bool isPlanned;
+    /** Information used by the event, selected by the event code */
+    union {
+        /** Used by MOVEMENT_EVENT and HOMING_EVENT */
+        MovementEvent movement;
+        /** Used by SLEEP_EVENT */
+        SleepEvent sleep;
+        /** Used by STREAM_EVENT */
+        StreamEvent stream;
+    };
+};
+static_assert(sizeof(EventNode) <= 44, "EventNode should stay compact so a deep queue fits in DTCM");
+
+/** Information about a crash the queue recovered from, it is reported to the computer by Communication */
+struct CrashRecovery {
+    /** Number of crashes recovered from since the controller started */
+    uint32_t count;
+    /** Axis that crashed (1 is the first axis) */
+    uint8_t axis;
+    /** Position of the crashed axis in steps according to the motor and according to the encoder */
+    int32_t motorSteps, encoderSteps;
+    /** Point in time when the crash was detected (micros()) */
+    uint32_t detectedTime;
+    /** Time taken to stop the arm and time it was then left to settle in microseconds */
+    uint32_t decelerationTime, settleTime;
+    /** Velocity the rest of the movement is performed at in degrees per microsecond */
+    double velocity;
 };
 
 class EventQueue {
 protected:
-    /** This is the head of the queue */
-    EventNode* head;
-    /** This is the tail of the queue */
-    EventNode* tail;
-    /** This is the size of the queue */
-    uint32_t queueSize;
+    /**
+     * Events waiting to be performed, the front of the ring is the event currently being performed.
+     * Events are added by the serial and calibration code and removed by update(), the ring lets
+     * the two sides work without locks or heap use.
+     */
+    SpscRing<EventNode, EVENT_QUEUE_SIZE> events;
+    /** Largest number of events that have been in the queue at once (only written by the producer) */
+    uint32_t highWaterMark = 0;
+    /** Number of events that could not be added since the queue was full (only written by the producer) */
+    uint32_t rejectedEvents = 0;
 
     /** Motors of the robot */
     Stepper* motors;
+    /** Step engine that sends the step pulses planned by the queue */
+    StepEngine stepEngine;
+
+    /** Trajectory of the movement being performed */
+    MovementProfile profile;
+    /** Point in time when the event started */
+    uint32_t eventStartTime = 0;
+    /** Fraction of the movement (Q32.32 held in a double) at the end of the last segment planned while stopping after a crash */
+    double segmentFraction = 0;
+    /** Point in time of the movement up to which steps have been handed to the step engine */
+    uint32_t plannedTime = 0;
+    /** Position of each axis in steps at the start and at the end of the movement */
+    int32_t initialSteps[DOF], targetSteps[DOF];
+    /** Number of steps of the movement that have been handed to the step engine for each axis */
+    uint32_t plannedSteps[DOF];
+    /** Number of events in the queue the last time the look-ahead planner was run */
+    uint32_t lookAheadSize = 0;
+    /**
+     * Velocities and profiles of the movements at the front of the queue. The event in slot i of the
+     * ring uses entry i % LOOK_AHEAD_PROFILES, and only the first LOOK_AHEAD_PROFILES events are
+     * planned ahead, so no two planned events share an entry.
+     */
+    PlannedMovement plannedMovements[LOOK_AHEAD_PROFILES];
+    /** Profiles of recently planned movements */
+    PlanCache<MovementProfile, PLAN_CACHE_SIZE> planCache;
 
-    /** Variables used for straight line movements */
-    double tap = 0, // Point in time when the movement stops accelerating
-        lap = 0, // Variable used in movement calculations for constant velocity
-        lcsp = 0, // Variable used in movement calculations for deceleration
-        tcsp = 0, // Point in time when the movement start decelerating
-        tfin = 0, // Point in time when the movement has finished
-        scaler = 0, // scaler used when calculating the degree change for each motor
-        velocity = 0, // peak velocity of the movement
-        acceleration = 0, // acceleration/deceleration of the movement
-        initVelocity = 0, // initial velocity of the movement
-        finalVelocity = 0, // final velocity of the movement
-        largestDegreeChange = 0; // largest degree change of all of the active axises
-    /** Variables that will be used during time calculations and events */
-    uint32_t eventStartTime = 0, timeDelta = 0;
-    /** array of degrees used to calculate and keep track of the arms current position */
-    double targetPosition[DOF], initialPosition[DOF];
+    /** State of the crash recovery, RECOVERY_NONE while no crash is being recovered from */
+    uint8_t recoveryState = RECOVERY_NONE;
+    /** Velocity of the arm while it stops after a crash in degrees of the largest degree change per microsecond */
+    double recoveryVelocity = 0;
+    /** Point in time when the current recovery state started (micros()) */
+    uint32_t recoveryStateTime = 0;
+    /** Crash currently being recovered from and the last crash that was recovered from */
+    CrashRecovery recovery = {}, lastRecovery = {};
+
+    /**
+     * Setpoints waiting to be played by a stream event. They are added by the serial code and removed
+     * by update() like the events, and belong to the first stream event that is performed.
+     */
+    SpscRing<Setpoint, STREAM_BUFFER_SIZE> setpoints;
+    /** State of the stream being played, STREAM_NONE while no stream event is being performed */
+    uint8_t streamState = STREAM_NONE;
+    /** The setpoint before the last one the stream has passed (only used by cubic interpolation) and the last one */
+    StreamPoint streamPoints[2];
+    /** Point in time of the stream on the computer's clock at the end of the last planned segment */
+    uint32_t streamTime = 0;
+    /** Position of each axis in steps at the end of the last planned segment */
+    int32_t streamSteps[DOF];
+    /** Axes that moved counterclockwise in the last planned segment (bit i is axis i) */
+    uint8_t streamDirections = 0;
+    /** Point in time when the stream started waiting for setpoints (micros()) */
+    uint32_t streamWaitTime = 0;
+    /** Used to determine if the stream was stopped by a crash, the motor positions are then taken from the encoders */
+    bool streamCrashed = false;
+    /** Number of times a stream ran out of setpoints while the arm was following it */
+    uint32_t streamUnderruns = 0;
 
     bool isRobotActive = false, // Used to determine if the controller is processing an event
         isRobotMoving = false; // Used to determine if the arm is physically moving
@@ -74,10 +262,40 @@ protected:
     uint32_t errorCode = 0;
 
     /**
-     * This function is used to add a new event to the end of the queue
-     * @param newEvent is the event being added
+     * This function is used to remove the event at the front of the queue without stopping the
+     * step engine, so the steps of a finished movement can run into the next movement
+     */
+    void popEvent();
+
+    /**
+     * Used to determine if an event can start while the steps of the movement before it are
+     * still being performed
+     * @param event is the event being checked, NULL if there is no event
+     * @return is true if the event is a movement that does not need the encoder position, otherwise false is returned
+     */
+    bool isChainedMovement(EventNode* event);
+
+    /**
+     * This function is used to plan the initial and final velocity and the profile of every queued
+     * movement that has not started (look-ahead). The velocity through each corner of the path is limited by how
+     * sharp the corner is and by the acceleration, and the limits are passed backwards from the last
+     * movement (which stops) and forwards from the movement being performed, so a path of short
+     * movements is followed without stopping at each point.
+     */
+    void planLookAhead();
+
+    /**
+     * This function is used to calculate the largest velocity the arm can keep through the corner
+     * between two movements (junction deviation). The arm is treated as following a circle that
+     * stays within JUNCTION_DEVIATION degrees of the corner.
+     * @param previousDelta is the degree change of each axis during the first movement
+     * @param previousLength is the length of the first movement in degrees
+     * @param delta is the degree change of each axis during the second movement
+     * @param length is the length of the second movement in degrees
+     * @param acceleration is the acceleration available in the corner in degrees per microsecond squared
+     * @return is the velocity through the corner in degrees per microsecond
      */
-    void addEvent(EventNode* newEvent);
+    double calculateJunctionVelocity(double* previousDelta, double previousLength, double* delta, double length, double acceleration);
 
     /** This function is used to process a sleep event */
     void processSleepEvent();
@@ -88,17 +306,194 @@ protected:
     /** This function is used to process a homing event */
     void processHomingEvent();
 
-    /** This function is used to perform all of the calculations for a movement event */
+    /**
+     * This function is used to process a stream event. The arm follows the setpoints sent by the
+     * computer, played the playback delay behind the newest setpoint and interpolated between them.
+     */
+    void processStreamEvent();
+
+    /**
+     * This function is used to wait until the playback delay of the stream is buffered, at the
+     * start of the stream and after it ran out of setpoints
+     * @param stream is the stream event being performed
+     * @return is true if the stream can be played, otherwise false is returned
+     */
+    bool bufferSetpoints(StreamEvent* stream);
+
+    /**
+     * This function is used to plan the next segment of the stream into the step engine's buffer
+     * @param stream is the stream event being performed
+     * @return is false if the segment could not be planned, otherwise true is returned
+     */
+    bool planStreamSegment(StreamEvent* stream);
+
+    /**
+     * This function is used to turn a setpoint into a point of the stream
+     * @param setpoint is the setpoint sent by the computer
+     * @param point is where the point is stored
+     */
+    void loadStreamPoint(Setpoint* setpoint, StreamPoint* point);
+
+    /**
+     * This function is used to work out the position of the stream between two setpoints. Cubic
+     * interpolation uses a Hermite spline whose slopes are taken from the setpoints on either
+     * side, so the velocity does not jump at each setpoint.
+     * @param points is the setpoint before, the two setpoints on either side of the time and the setpoint after
+     * @param time is the point in time of the stream on the computer's clock
+     * @param interpolation is STREAM_LINEAR or STREAM_CUBIC
+     * @param target is where the position of each axis in steps is stored
+     */
+    void interpolateStream(StreamPoint** points, uint32_t time, uint8_t interpolation, double* target);
+
+    /**
+     * This function is used to work out the segment that moves the arm towards a position of the
+     * stream. No axis is moved faster than its velocity limit or the step engine allows, an axis
+     * that falls behind catches up in the following segments.
+     * @param target is the position of each axis in steps
+     * @param duration is the length of the segment in microseconds
+     * @param segment is where the segment is stored
+     */
+    void buildStreamSegment(double* target, uint32_t duration, StepSegment* segment);
+
+    /**
+     * This function is used to start recovering from a crash of the movement being performed. The
+     * recovery is done by processCrashRecovery() over the following updates, so the serial port and
+     * the rest of the controller keep being serviced.
+     * @param axis is the index of the axis that crashed
+     * @param snapshot is the encoder snapshot the crash was found in
+     */
+    void startCrashRecovery(int axis, EncoderSnapshot* snapshot);
+
+    /**
+     * This function is used to perform the next step of the crash recovery. The arm is slowed to a
+     * stop along the path of the movement, left to settle, then the motor positions are taken from
+     * the encoders and the rest of the movement is planned again at half the velocity.
+     */
+    void processCrashRecovery();
+
+    /** This function is used to plan the next segment of the stop that follows a crash */
+    void planStoppingSegment();
+
+    /**
+     * This function is used to start the movement or homing event at the front of the queue. Its
+     * profile is copied from the event, it is only calculated here if the event was not planned
+     * from the position the arm is starting at.
+     */
     void calculateMovementEvent();
 
     /**
-     * This function is used to perform a trajectory
-     * @param updatedTrajectory is the new Trajectory
+     * This function is used to get the entry of the profile table used by an event
+     * @param event is an event of the queue
+     * @return is the entry of the event, it is only valid once the look-ahead planner has reached the event
+     */
+    PlannedMovement* getPlannedMovement(EventNode* event);
+
+    /**
+     * This function is used to perform all of the calculations for a movement or homing event.
+     * The profile is copied from the plan cache if the same movement was planned recently
+     * @param movement is the movement being planned
+     * @param initialSteps is the position of each axis in steps at the start of the movement
+     * @param planned holds the velocities the movement starts and ends at, its profile is stored there
+     */
+    void planMovement(MovementEvent* movement, int32_t* initialSteps, PlannedMovement* planned);
+
+    /**
+     * This function is used to work out the phases of a 7 segment S-curve profile. The acceleration
+     * rises and falls at the jerk of the profile instead of jumping at the start and end of the
+     * acceleration and deceleration phases.
+     * @param profile is the profile being planned, its velocities must already be reachable
+     */
+    void planSCurve(MovementProfile* profile);
+
+    /**
+     * This function is used to lower the velocity and acceleration of a movement so that no axis
+     * goes past the limits of its motor. The axes stay synchronized, so the axis that needs the
+     * lowest values sets them for the whole movement, which then takes the shortest time it can.
+     * @param degreeChange is the degree change of each axis during the movement
+     * @param largestDegreeChange is the largest degree change of all of the axes
+     * @param velocity is the velocity of the movement, it is lowered if needed
+     * @param acceleration is the acceleration of the movement, it is lowered if needed
+     */
+    void limitToAxes(double* degreeChange, double largestDegreeChange, double* velocity, double* acceleration);
+
+    /**
+     * This function is used to calculate how long it takes to change velocity. With a jerk the
+     * acceleration rises at the jerk, stays at the acceleration limit and falls back at the jerk.
+     * @param velocityChange is the change in velocity in degrees per microsecond
+     * @param acceleration is the largest acceleration in degrees per microsecond squared
+     * @param jerk is the jerk in degrees per microsecond cubed, 0 for a constant acceleration
+     * @param jerkTime is set to the time spent changing the acceleration at each end of the change
+     * @return is the time taken to change velocity in microseconds
+     */
+    static double calculateRampTime(double velocityChange, double acceleration, double jerk, double* jerkTime);
+
+    /**
+     * This function is used to calculate the velocity that can be reached from another velocity
+     * @param velocity is the starting velocity in degrees per microsecond
+     * @param distance is the distance available to change velocity in degrees
+     * @param acceleration is the largest acceleration in degrees per microsecond squared
+     * @param jerk is the jerk in degrees per microsecond cubed, 0 for a constant acceleration
+     * @param accelerate is true to find the highest velocity, false to find the lowest velocity
+     * @return is the highest or lowest velocity that can be reached in degrees per microsecond
+     */
+    static double calculateReachableVelocity(double velocity, double distance, double acceleration, double jerk, bool accelerate);
+
+    /**
+     * This function is used to calculate how far the arm has travelled while speeding up in an S-curve phase
+     * @param time is the time since the start of the phase in microseconds
+     * @param startVelocity is the velocity at the start of the phase
+     * @param endVelocity is the velocity at the end of the phase (not less than the start velocity)
+     * @param jerkTime is the time spent changing the acceleration at each end of the phase
+     * @param duration is the length of the phase in microseconds
+     * @return is the distance travelled in degrees of the largest degree change
      */
-    void performTrajectory(double* updatedTrajectory);
+    double calculateRampPosition(double time, double startVelocity, double endVelocity, double jerkTime, double duration);
+
+    /**
+     * Used to determine if the profile of a movement was planned from a position
+     * @param event is the movement or homing event being checked
+     * @param initialSteps is the position of each axis in steps
+     * @return is true if the movement was planned to start at the position, otherwise false is returned
+     */
+    bool isPlannedFrom(EventNode* event, int32_t* initialSteps);
+
+    /**
+     * This function is used to calculate how far along the movement the arm should be
+     * @param time is the point in time of the movement in microseconds
+     * @return is the distance along the movement in degrees of the largest degree change
+     */
+    double calculateScaler(double time);
+
+    /**
+     * This function is used to plan segments of the current movement into the step engine's buffer
+     * until the buffer is full or the whole movement has been planned.
+     */
+    void planSegments();
+
+    /** This function is used to plan the next segment of the current movement into the step engine's buffer */
+    void planNextSegment();
+
+    /**
+     * This function is used to perform a trajectory. The steps needed to reach the new trajectory
+     * are handed to the step engine which spreads them over the duration
+     * @param movementFraction is how far along the movement the new trajectory is (Q32.32, MOVEMENT_FRACTION_ONE is the target)
+     * @param duration is the time the step engine has to reach the new trajectory in microseconds
+     */
+    void performTrajectory(int64_t movementFraction, uint32_t duration);
+
+    /**
+     * This function is used to work out the segment that reaches a new trajectory
+     * @param movementFraction is how far along the movement the new trajectory is (Q32.32, MOVEMENT_FRACTION_ONE is the target)
+     * @param duration is the time the step engine has to reach the new trajectory in microseconds
+     * @param segment is where the segment is stored
+     */
+    void buildSegment(int64_t movementFraction, uint32_t duration, StepSegment* segment);
 
 public:
-    /** This function is used to remove the current event and replace it with the next event in the queue */
+    /**
+     * This function is used to remove the current event and replace it with the next event in the queue.
+     * Any steps of the event that have not been performed are dropped.
+     */
     void eventCompleted();
 
     /** Used to construct a new Event Queue and initialize fields */
@@ -128,6 +523,143 @@ public:
      */
     uint32_t getQueueSize();
 
+    /**
+     * Used to get the number of events the queue can hold
+     * @return is the capacity of the event queue
+     */
+    uint32_t getQueueCapacity();
+
+    /**
+     * Used to get the largest number of events that have been in the queue at once
+     * @return is the high water mark of the event queue
+     */
+    uint32_t getHighWaterMark();
+
+    /**
+     * Used to get the number of events that could not be added since the queue was full
+     * @return is the number of rejected events
+     */
+    uint32_t getRejectedEvents();
+
+    /**
+     * This function is used to get a free slot at the end of the queue for a new event. The event
+     * is only added once it is filled in and commitEvent() is called, so a batch of events can be
+     * filled in place and then added together (or dropped by not committing them).
+     * @param index is the number of slots already reserved for the batch (0 for a single event)
+     * @return is the free slot, or NULL if the queue is full (the error code is set)
+     */
+    EventNode* reserveEvent(uint32_t index = 0);
+
+    /**
+     * This function is used to add the events in the slots returned by reserveEvent() to the queue
+     * @param count is the number of slots being added, in the order they were reserved
+     */
+    void commitEvent(uint32_t count = 1);
+
+    /**
+     * This function is used to fill in a movement or homing event in a reserved slot
+     * @param event is the slot returned by reserveEvent()
+     * @param eventCode is the code of the event (MOVEMENT_EVENT or HOMING_EVENT)
+     * @see addMovementEvent for the other parameters
+     * @return is false if the movement is not valid (the error code is set), otherwise true is returned
+     */
+    bool setMovementEvent(
+        EventNode* event,
+        uint8_t eventCode,
+        double* finalPosition,
+        double velocity,
+        double acceleration,
+        bool useEncoderPosition,
+        double jerk);
+
+    /**
+     * This function is used to fill in a sleep event in a reserved slot
+     * @param event is the slot returned by reserveEvent()
+     * @param sleepTime is the amount of time the event will be sleeping in microseconds
+     */
+    void setSleepEvent(EventNode* event, uint32_t sleepTime);
+
+    /**
+     * This function is used to fill in a homing event in a reserved slot
+     * @param event is the slot returned by reserveEvent()
+     * @param velocity is the velocity of the homing event
+     * @param acceleration is the acceleration of the homing event
+     * @return is false if the event is not valid, otherwise true is returned
+     */
+    bool setHomingEvent(EventNode* event, double velocity, double acceleration);
+
+    /**
+     * This function is used to get a free slot at the end of the setpoint ring, it is used the same
+     * way as reserveEvent()
+     * @param index is the number of slots already reserved for the batch (0 for a single setpoint)
+     * @return is the free slot, or NULL if the ring is full
+     */
+    Setpoint* reserveSetpoint(uint32_t index = 0);
+
+    /**
+     * This function is used to add the setpoints in the slots returned by reserveSetpoint() to the stream
+     * @param count is the number of slots being added, in the order they were reserved
+     */
+    void commitSetpoints(uint32_t count = 1);
+
+    /**
+     * Used to determine if a setpoint can be followed by the arm
+     * @param setpoint is the setpoint being checked
+     * @return is false if the setpoint is outside of the motor bounds (the error code is set), otherwise true is returned
+     */
+    bool checkSetpoint(Setpoint* setpoint);
+
+    /**
+     * This function is used to fill in a stream event in a reserved slot
+     * @param event is the slot returned by reserveEvent()
+     * @param playbackDelay is the time the stream is played behind the newest setpoint in microseconds
+     * @param interpolation is STREAM_LINEAR or STREAM_CUBIC
+     * @return is false if the interpolation is unknown (the error code is set), otherwise true is returned
+     */
+    bool setStreamEvent(EventNode* event, uint32_t playbackDelay, uint8_t interpolation);
+
+    /**
+     * Used to get the number of setpoints waiting to be played
+     * @return is the number of buffered setpoints
+     */
+    uint32_t getBufferedSetpoints();
+
+    /**
+     * Used to get the number of times a stream ran out of setpoints while the arm was following it
+     * @return is the number of stream underruns
+     */
+    uint32_t getStreamUnderruns();
+
+    /** This function is used to reset the high water mark, the number of rejected events, the plan cache counts and the stream underruns */
+    void resetQueueStatistics();
+
+    /**
+     * This function is used to get the number of movements whose profile was found in the plan cache
+     * @return is the number of plan cache hits
+     */
+    uint32_t getPlanCacheHits();
+
+    /**
+     * This function is used to get the number of movements that had to be planned
+     * @return is the number of plan cache misses
+     */
+    uint32_t getPlanCacheMisses();
+
+    /** This function is used to empty the plan cache, it has to be called when the motion limits of a motor change */
+    void clearPlanCache();
+
+    /**
+     * This function is used to get the last crash the queue recovered from
+     * @return is the last crash, its count is 0 if there has not been a crash
+     */
+    CrashRecovery* getLastCrashRecovery();
+
+    /**
+     * Used to determine if the queue is recovering from a crash
+     * @return is true if the arm is being stopped or left to settle after a crash, otherwise false is returned
+     */
+    bool isRecoveringFromCrash();
+
     /**
      * This function is used to get the latest error code
      * @return is the latest error code
@@ -137,8 +669,9 @@ public:
     /**
      * This function is used to add a sleep event to the queue
      * @param sleepTime is the amount of time the event will be sleeping in microseconds
+     * @return is false if the queue is full, otherwise true is returned
      */
-    void addSleepEvent(uint32_t sleepTime);
+    bool addSleepEvent(uint32_t sleepTime);
 
     /**
      * This function is used to add a movement to the event queue. If an error occurs
@@ -146,30 +679,40 @@ public:
      * @param finalPosition is an array of angles that the motors will move
      * @param velocity is the velocity the motors will travel at
      * @param acceleration is the acceleration/deceleration of the movement
-     * @param initVelocity is the initial velocity of the movement
-     * @param finalVelocity is the final velocity of the movement0
      * @param useEncoderPosition is used to determine if the arm should use encoder position
+     * @param jerk is the jerk of an S-curve profile, 0 for a trapezoid profile
      * @return is false if the movement cannot be added, otherwise true is returned
      */
     bool addMovementEvent(
         double* finalPosition,
         double velocity,
         double acceleration,
-        double initVelocity,
-        double finalVelocity,
-        bool useEncoderPosition);
-
-    /**
-     * This function is used to add a movement to the event queue. If an error occurs
-     * the correct error code will be placed in to the error field
-     * @param data contains all of the information needed for a movement
-     */
-    bool addMovementEvent(double* data);
+        bool useEncoderPosition,
+        double jerk = 0);
 
     /**
      * This function is used to add a homing event to the queue
      * @param velocity is the velocity of the homing event
      * @param acceleration is the acceleration of the homing event
+     * @return is false if the event cannot be added, otherwise true is returned
+     */
+    bool addHomingEvent(double velocity, double acceleration);
+
+    /**
+     * This function is used to add a stream event to the queue. When the event is reached the arm
+     * follows the setpoints added with addSetpoint() until the setpoint that ends the stream.
+     * @param playbackDelay is the time the stream is played behind the newest setpoint in microseconds
+     * @param interpolation is STREAM_LINEAR or STREAM_CUBIC
+     * @return is false if the event cannot be added, otherwise true is returned
+     */
+    bool addStreamEvent(uint32_t playbackDelay, uint8_t interpolation);
+
+    /**
+     * This function is used to add a setpoint to the stream
+     * @param timestamp is the point in time of the setpoint on the computer's clock in microseconds
+     * @param position is the angle of each axis in degrees
+     * @param isEnd is true if the setpoint is the last of the stream
+     * @return is false if the setpoint cannot be added, otherwise true is returned
      */
-    void addHomingEvent(double velocity, double acceleration);
+    bool addSetpoint(uint32_t timestamp, double* position, bool isEnd);
 };
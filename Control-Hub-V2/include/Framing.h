@@ -0,0 +1,101 @@
+/**
+ * This file contains the functions used to frame the data sent over the serial port. Each frame
+ * is COBS (Consistent Overhead Byte Stuffing) encoded so that it holds no zero bytes and is ended
+ * with a zero byte, which lets the receiver find the start of the next frame after any error. The
+ * last two bytes of a decoded frame are a CRC-16 of the rest of the frame. The frames sent to the
+ * computer also start with a delimiter, so they can be found among the text lines, and the first
+ * byte of each decoded frame is its type.
+ *
+ * @author Thomas Batchelder
+ * @file Framing.h
+ * @date 10/17/2026 - File created
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/** Byte that ends every frame */
+#define FRAME_DELIMITER 0x00
+/** Number of bytes used by the CRC at the end of a decoded frame */
+#define FRAME_CRC_SIZE 2
+/** Value the CRC starts at before any data is added */
+#define FRAME_CRC_INITIAL 0xFFFF
+/** Most bytes a frame sent to the computer takes once it is encoded, with a delimiter before and after it */
+#define FRAME_ENCODED_SIZE(length) ((length) + FRAME_CRC_SIZE + ((length) + FRAME_CRC_SIZE) / 254 + 1 + 2)
+
+/** Type of a frame sent to the computer, the first byte of the decoded frame */
+#define FRAME_TELEMETRY 1 // State of the arm (see Telemetry.h)
+#define FRAME_CRASH_RECOVERY 2 // Last crash the event queue recovered from (see Telemetry.h)
+#define FRAME_ACK 3 // A frame from the computer was used (see Communication.h)
+#define FRAME_NACK 4 // A frame from the computer was dropped (see Communication.h)
+#define FRAME_CREDIT 5 // Slots have freed up in the event queue (see Communication.h)
+
+/**
+ * This function is used to calculate the CRC-16/CCITT-FALSE of a block of data
+ * (polynomial 0x1021, initial value 0xFFFF)
+ * @param data is the data
+ * @param length is the number of bytes in the data
+ * @return is the CRC of the data
+ */
+uint16_t calculateCrc16(const uint8_t* data, size_t length);
+
+/**
+ * This function is used to add one byte to a CRC-16/CCITT-FALSE, so the CRC of a frame can be
+ * worked out while it is decoded
+ * @param crc is the CRC of the data before the byte (FRAME_CRC_INITIAL for no data)
+ * @param value is the byte being added
+ * @return is the CRC of the data including the byte
+ */
+uint16_t updateCrc16(uint16_t crc, uint8_t value);
+
+/** State of a COBS decoder that is given the bytes of a frame one at a time */
+struct CobsDecoder {
+    /** Number of bytes left in the current block */
+    uint8_t blockRemaining;
+    /** Used to determine if a zero is decoded when the next block starts */
+    bool zeroPending;
+};
+
+/**
+ * This function is used to get a decoder ready for the start of a frame
+ * @param decoder is the decoder
+ */
+void resetCobs(CobsDecoder* decoder);
+
+/**
+ * This function is used to decode the next byte of a COBS encoded frame. Each encoded byte gives
+ * at most one decoded byte, so the frame never has to be held in a buffer.
+ * @param decoder is the decoder
+ * @param value is the encoded byte (never the delimiter)
+ * @param output is where the decoded byte is stored
+ * @return is true if a byte was decoded, otherwise false is returned
+ */
+bool decodeCobs(CobsDecoder* decoder, uint8_t value, uint8_t* output);
+
+/**
+ * Used to determine if the frame given to a decoder ended where a block ended
+ * @param decoder is the decoder
+ * @return is true if the frame is complete, false if it was cut short
+ */
+bool isCobsComplete(CobsDecoder* decoder);
+
+/**
+ * This function is used to COBS encode a frame
+ * @param data is the frame being encoded
+ * @param length is the number of bytes in the frame
+ * @param output is where the encoded frame is stored, it needs room for length + length / 254 + 1 bytes
+ * (the delimiter is not added)
+ * @return is the number of bytes in the encoded frame
+ */
+size_t encodeCobs(const uint8_t* data, size_t length, uint8_t* output);
+
+/**
+ * This function is used to encode a frame sent to the computer. The CRC is added after the frame and
+ * the frame is COBS encoded between two delimiters.
+ * @param frame is the frame being encoded, starting with its type. It needs room for the CRC after its length
+ * @param length is the number of bytes in the frame
+ * @param output is where the encoded frame is stored, it needs room for FRAME_ENCODED_SIZE(length) bytes
+ * @return is the number of bytes in the encoded frame
+ */
+size_t encodeFrame(uint8_t* frame, size_t length, uint8_t* output);
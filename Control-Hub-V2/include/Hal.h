@@ -0,0 +1,38 @@
+/**
+ * This file is the hardware abstraction layer used by the motion core. On the microcontroller it
+ * pulls in the Teensy core and the Encoder library. When the motion core is built on a computer
+ * ([env:native]) it pulls in stand-ins for the parts of the Arduino API that the arm uses: a
+ * virtual clock, mock GPIO, a virtual serial port, virtual encoders and a timer that is run by
+ * the virtual clock.
+ *
+ * @author Thomas Batchelder
+ * @file Hal.h
+ * @date 10/17/2026 - File created
+ */
+
+#pragma once
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <Encoder.h>
+#else
+#include "hal/HostArduino.h"
+#include "hal/HostEncoder.h"
+#include "hal/HostTimer.h"
+#endif
+
+#ifdef ARDUINO
+/**
+ * This function is used to get the count the Encoder library's interrupt keeps up to date for an
+ * encoder. Encoder::read() turns interrupts back on once it is done, so encoders that have to be read
+ * together are read through their counts in one critical section instead. Every pin of the Teensy 4.1
+ * can interrupt, so the count of every encoder is kept by its interrupt.
+ * @param encoder is the encoder (only used on a computer)
+ * @param pin is the first pin of the encoder
+ * @return is the count of the encoder
+ */
+inline volatile int32_t* getEncoderCount(Encoder* encoder, uint8_t pin)
+{
+    return &Encoder::interruptArgs[pin]->position;
+}
+#endif
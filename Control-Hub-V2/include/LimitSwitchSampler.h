@@ -0,0 +1,73 @@
+/**
+ * This file contains the limit switch sampler. The sampler reads every limit switch from a timer
+ * interrupt and debounces each one with a shift register filter. The debounced state of all
+ * switches is kept in a single mask so the motors and the homing code never have to wait on
+ * the switches themselves.
+ *
+ * @author Thomas Batchelder
+ * @file LimitSwitchSampler.h
+ * @date 10/17/2026 - File created
+ */
+
+#pragma once
+#include "Configuration.h"
+#include "Hal.h"
+
+static_assert(LIMIT_SWITCH_SAMPLES >= 1 && LIMIT_SWITCH_SAMPLES <= 16, "The readings of each switch are kept in 16 bits");
+
+/**
+ * This class is used to sample and debounce all of the limit switches in the background
+ */
+class LimitSwitchSampler {
+protected:
+    /** Pins connected to the limit switches */
+    uint8_t limPins[DOF];
+    /** The last LIMIT_SWITCH_SAMPLES readings of each switch, the newest reading is bit 0 */
+    volatile uint16_t sampleHistory[DOF];
+    /** Debounced state of all switches, bit i is set if the switch of axis i + 1 is pressed */
+    volatile uint8_t limitMask = 0;
+
+    /** Timer used to run the sampling interrupt */
+    IntervalTimer timer;
+
+    /** The sampler serviced by the timer interrupt */
+    static LimitSwitchSampler* activeSampler;
+
+    /** Function called by the timer, forwards the interrupt to the active sampler */
+    static void timerInterrupt();
+
+    /** This function is used to read every switch once and update the debounced mask */
+    void sample();
+
+public:
+    /**
+     * Used to construct a new limit switch sampler
+     * @param limPins are the pins connected to the limit switch of each axis
+     */
+    LimitSwitchSampler(uint8_t* limPins);
+
+    /** Default Constructor */
+    LimitSwitchSampler() { }
+
+    /** This function is used to start sampling the limit switches */
+    void begin();
+
+    /**
+     * This function is used to get the debounced state of all limit switches
+     * @return is a mask with bit i set if the switch of axis i + 1 is pressed
+     */
+    uint8_t getLimitMask();
+
+    /**
+     * This function is used to get the debounced state of a single limit switch
+     * @param axis is the axis of the switch (starting at 0)
+     * @return is true if the switch is pressed, otherwise false is returned
+     */
+    bool isPressed(int axis) { return this->limitMask & (1 << axis); }
+
+    /**
+     * This function is used to run the timer when there are no timer interrupts (computer builds).
+     * It does nothing on the microcontroller.
+     */
+    void poll();
+};
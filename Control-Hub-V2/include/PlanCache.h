@@ -0,0 +1,123 @@
+/**
+ * This file contains a small least recently used cache of planned movements. Jobs sent by the
+ * computer often repeat the same movements, and a movement that starts at the same position with
+ * the same target and the same velocities always ends up with the same profile, so its profile is
+ * copied from the cache instead of being worked out again.
+ *
+ * @author Thomas Batchelder
+ * @file PlanCache.h
+ * @date 10/17/2026 - File created
+ */
+
+#pragma once
+#include "Configuration.h"
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Everything a planned profile depends on. Positions are already whole steps and the kinematic
+ * values are stored as floats in the queue, so equal movements give keys that are equal byte for
+ * byte (the struct has no padding).
+ */
+struct PlanKey {
+    /** Position of each axis in steps at the start and at the end of the movement */
+    int32_t initialSteps[DOF], targetSteps[DOF];
+    /** Kinematic values of the movement as they are stored in the queue */
+    float velocity, acceleration, initVelocity, finalVelocity, jerk;
+};
+
+/**
+ * Least recently used cache of planned profiles
+ * @tparam T is the type of the profiles held by the cache
+ * @tparam capacity is the number of profiles the cache can hold
+ */
+template <class T, uint32_t capacity>
+class PlanCache {
+    static_assert(capacity > 0, "The plan cache must hold at least one profile");
+
+protected:
+    /** A cached profile and the movement it was planned for */
+    struct Entry {
+        PlanKey key;
+        T profile;
+        /** Value of the use counter the last time the entry was used, 0 if the entry is empty */
+        uint32_t lastUsed;
+    };
+
+    /** Storage of the profiles */
+    Entry entries[capacity];
+    /** Raised every time an entry is used, so the entry with the lowest value is the least recently used */
+    uint32_t useCounter = 0;
+    /** Number of lookups that found a profile */
+    uint32_t hits = 0;
+    /** Number of lookups that did not find a profile */
+    uint32_t misses = 0;
+
+public:
+    PlanCache() { clear(); }
+
+    /**
+     * This function is used to find the profile planned for a movement
+     * @param key is the movement being looked up
+     * @param profile is where the profile is copied to if it is found
+     * @return is true if the profile was found, otherwise false is returned
+     */
+    bool lookup(const PlanKey& key, T* profile)
+    {
+        for (uint32_t i = 0; i < capacity; i++) {
+            if (this->entries[i].lastUsed != 0 && memcmp(&this->entries[i].key, &key, sizeof(PlanKey)) == 0) {
+                this->entries[i].lastUsed = ++this->useCounter;
+                *profile = this->entries[i].profile;
+                this->hits++;
+                return true;
+            }
+        }
+        this->misses++;
+        return false;
+    }
+
+    /**
+     * This function is used to add the profile planned for a movement, it replaces the least
+     * recently used profile if the cache is full
+     * @param key is the movement the profile was planned for
+     * @param profile is the planned profile
+     */
+    void store(const PlanKey& key, const T& profile)
+    {
+        Entry* oldest = &this->entries[0];
+        for (uint32_t i = 1; i < capacity; i++) {
+            if (this->entries[i].lastUsed < oldest->lastUsed)
+                oldest = &this->entries[i];
+        }
+        oldest->key = key;
+        oldest->profile = profile;
+        oldest->lastUsed = ++this->useCounter;
+    }
+
+    /** This function is used to remove every profile, the hit and miss counts are kept */
+    void clear()
+    {
+        for (uint32_t i = 0; i < capacity; i++)
+            this->entries[i].lastUsed = 0;
+        this->useCounter = 0;
+    }
+
+    /**
+     * Used to get the number of lookups that found a profile
+     * @return is the number of hits
+     */
+    uint32_t getHits() const { return this->hits; }
+
+    /**
+     * Used to get the number of lookups that did not find a profile
+     * @return is the number of misses
+     */
+    uint32_t getMisses() const { return this->misses; }
+
+    /** This function is used to reset the hit and miss counts */
+    void resetStatistics()
+    {
+        this->hits = 0;
+        this->misses = 0;
+    }
+};
@@ -0,0 +1,167 @@
+/**
+ * This file contains a fixed capacity single producer, single consumer ring buffer. One side of
+ * the program (for example the serial parser) adds items while another side (for example the
+ * motion code) removes them, without locks and without using the heap. The producer only writes
+ * the tail index and the consumer only writes the head index, each index is published with
+ * release ordering and read with acquire ordering, so the producer can also be an interrupt.
+ *
+ * @author Thomas Batchelder
+ * @file SpscRing.h
+ * @date 10/17/2026 - File created
+ */
+
+#pragma once
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * Single producer, single consumer ring buffer
+ * @tparam T is the type of the items held by the ring
+ * @tparam capacity is the number of items the ring can hold (must be a power of two)
+ */
+template <class T, uint32_t capacity>
+class SpscRing {
+    static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "The capacity of the ring must be a power of two");
+
+protected:
+    /** Storage of the items */
+    T items[capacity];
+    /** Number of items removed since the ring was created (only written by the consumer) */
+    std::atomic<uint32_t> head;
+    /** Number of items added since the ring was created (only written by the producer) */
+    std::atomic<uint32_t> tail;
+
+public:
+    SpscRing() : head(0), tail(0) { }
+    SpscRing(const SpscRing& other) : head(0), tail(0) { *this = other; }
+
+    /** Copying a ring copies the items it holds, it must not be in use while it is copied */
+    SpscRing& operator=(const SpscRing& other)
+    {
+        for (uint32_t i = 0; i < capacity; i++)
+            this->items[i] = other.items[i];
+        this->head.store(other.head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        this->tail.store(other.tail.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    // +---------------------------------------------------+ //
+    // |                  --- Producer ---                 | //
+    // +---------------------------------------------------+ //
+
+    /**
+     * This function is used to get a free slot at the end of the ring. The slot is filled in
+     * place and only becomes visible to the consumer once commit() is called.
+     * @param index is the position of the slot counted from the first free slot, so several slots can be filled before they are committed
+     * @return is the free slot, or NULL if the ring does not have that many free slots
+     */
+    T* reserve(uint32_t index = 0)
+    {
+        uint32_t currentTail = this->tail.load(std::memory_order_relaxed);
+        if (currentTail + index - this->head.load(std::memory_order_acquire) >= capacity)
+            return NULL;
+        return &this->items[(currentTail + index) & (capacity - 1)];
+    }
+
+    /**
+     * This function is used to hand the slots returned by reserve() to the consumer
+     * @param count is the number of slots being handed over, starting with the first free slot
+     */
+    void commit(uint32_t count = 1)
+    {
+        this->tail.store(this->tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    /**
+     * This function is used to copy an item to the end of the ring
+     * @param item is the item being added
+     * @return is false if the ring is full, otherwise true is returned
+     */
+    bool push(const T& item)
+    {
+        T* slot = reserve();
+        if (slot == NULL)
+            return false;
+        *slot = item;
+        commit();
+        return true;
+    }
+
+    // +---------------------------------------------------+ //
+    // |                  --- Consumer ---                 | //
+    // +---------------------------------------------------+ //
+
+    /**
+     * This function is used to get the item at the front of the ring. The item stays in the ring
+     * until pop() is called, so the consumer can keep working on it in place.
+     * @return is the item at the front, or NULL if the ring is empty
+     */
+    T* front()
+    {
+        uint32_t currentHead = this->head.load(std::memory_order_relaxed);
+        if (currentHead == this->tail.load(std::memory_order_acquire))
+            return NULL;
+        return &this->items[currentHead & (capacity - 1)];
+    }
+
+    /**
+     * This function is used to get an item behind the front of the ring. Items that have been
+     * committed are only changed by the consumer, so it is free to work on them in place.
+     * @param index is the position of the item counted from the front (0 is the front)
+     * @return is the item, or NULL if the ring holds no more than index items
+     */
+    T* at(uint32_t index)
+    {
+        uint32_t currentHead = this->head.load(std::memory_order_relaxed);
+        if (this->tail.load(std::memory_order_acquire) - currentHead <= index)
+            return NULL;
+        return &this->items[(currentHead + index) & (capacity - 1)];
+    }
+
+    /** This function is used to remove the item at the front of the ring */
+    void pop()
+    {
+        uint32_t currentHead = this->head.load(std::memory_order_relaxed);
+        if (currentHead != this->tail.load(std::memory_order_acquire))
+            this->head.store(currentHead + 1, std::memory_order_release);
+    }
+
+    // +---------------------------------------------------+ //
+    // |                   --- Either ---                  | //
+    // +---------------------------------------------------+ //
+
+    /**
+     * Used to get the number of items in the ring
+     * @return is the number of items
+     */
+    uint32_t size() const
+    {
+        return this->tail.load(std::memory_order_acquire) - this->head.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Used to determine if the ring is empty
+     * @return is true if the ring holds no items, otherwise false is returned
+     */
+    bool isEmpty() const { return size() == 0; }
+
+    /**
+     * Used to determine if the ring is full
+     * @return is true if no more items can be added, otherwise false is returned
+     */
+    bool isFull() const { return size() >= capacity; }
+
+    /**
+     * Used to get the position of an item in the storage of the ring, so information about the item
+     * can be kept in a table beside the ring
+     * @param item is an item of the ring
+     * @return is the position of the item, from 0 to the capacity of the ring
+     */
+    uint32_t indexOf(const T* item) const { return item - this->items; }
+
+    /**
+     * Used to get the number of items the ring can hold
+     * @return is the capacity of the ring
+     */
+    static constexpr uint32_t getCapacity() { return capacity; }
+};
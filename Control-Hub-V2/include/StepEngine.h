@@ -0,0 +1,150 @@
+/**
+ * This file contains the step engine. The step engine is responsible for sending step pulses
+ * to the motors from a timer interrupt so that the timing of each step does not depend on how
+ * often the main loop runs. The EventQueue plans segments of steps ahead of time into a ring buffer,
+ * and the engine interleaves the steps of all axes evenly over each segment (Bresenham).
+ *
+ * @author Thomas Batchelder
+ * @file StepEngine.h
+ * @date 10/17/2026 - File created
+ */
+
+#pragma once
+#include "Configuration.h"
+#include "Hal.h"
+#include "StepOutput.h"
+#include "StepRecorder.h"
+#include "Stepper.h"
+
+/**
+ * A block of steps that the step engine spreads evenly over its duration. The timing and
+ * the direction of each axis are worked out when the segment is planned so the interrupt
+ * only has to pop it from the buffer.
+ */
+struct StepSegment {
+    /** Number of steps each axis has to take during the segment */
+    uint16_t steps[DOF];
+    /** Axes that move counterclockwise during the segment (bit i is axis i) */
+    uint8_t directionMask;
+    /** Number of steps of the axis with the most steps in the segment */
+    uint16_t dominantSteps;
+    /** Time between each step of the dominant axis in microseconds */
+    float interval;
+};
+
+/**
+ * This class is used to generate the step pulses for all of the motors from a timer interrupt.
+ * Segments are planned ahead of time into a ring buffer that the interrupt pops from, so the time
+ * taken to plan a segment never delays a step. The timer runs once for every
+ * step of the dominant axis of the segment, and the other axes step on the same interrupts using
+ * a Bresenham error term so all axes move together.
+ */
+class StepEngine {
+protected:
+    /**
+     * Motors of the robot, built by Stepper::fromConfig() since the interrupt takes the settings of each
+     * axis from AxisConfig rather than from the motor
+     */
+    Stepper* motors;
+    /** Output used to write the step and direction pins of all motors */
+    StepOutput output;
+    /** Timer used to run the step interrupt */
+    IntervalTimer timer;
+    /** Used to determine if the timer has been started */
+    bool timerRunning = false;
+
+    /** Ring buffer of segments waiting to be performed */
+    StepSegment segmentBuffer[STEP_SEGMENT_BUFFER_SIZE];
+    /** Index of the next segment the interrupt performs (only changed by the interrupt) */
+    volatile uint8_t bufferHead = 0;
+    /** Index of the next free slot in the buffer (only changed by the planner) */
+    volatile uint8_t bufferTail = 0;
+    /** Number of steps each axis takes during the current segment */
+    volatile uint32_t segmentSteps[DOF];
+    /** Bresenham error term of each axis */
+    volatile uint32_t stepError[DOF];
+    /** Number of timer interrupts in the current segment (steps of the dominant axis) */
+    volatile uint32_t dominantSteps = 0;
+    /** Number of timer interrupts that have been run in the current segment */
+    volatile uint32_t stepCount = 0;
+    /** Time between each step of the dominant axis in the current segment in microseconds */
+    volatile float segmentInterval = 0;
+
+    /** Used to determine if a segment is currently being performed */
+    volatile bool segmentActive = false;
+    /** Axes whose motors are currently set to move counterclockwise (bit i is axis i) */
+    uint8_t currentDirections = 0;
+
+    /** The step engine serviced by the timer interrupt */
+    static StepEngine* activeEngine;
+
+    /** Function called by the timer, forwards the interrupt to the active engine */
+    static void timerInterrupt();
+
+    /** This function is run every timer interrupt and sends the step pulses that are due */
+    void tick();
+
+    /**
+     * This function is used to pop the next segment from the buffer, set the directions of
+     * its axes and restart the timer with the step interval of its dominant axis
+     * @return is false if the buffer is empty, otherwise true is returned
+     */
+    bool loadSegment();
+
+    /**
+     * This function is used to set the direction of every motor and write the direction pins
+     * @param directionMask is the axes that move counterclockwise (bit i is axis i)
+     */
+    void setDirections(uint8_t directionMask);
+
+public:
+    /**
+     * Used to construct a new step engine
+     * @param motors is the array of motors that are going to be stepped
+     */
+    StepEngine(Stepper* motors);
+
+    /** Default Constructor */
+    StepEngine() { }
+
+    /**
+     * This function is used to add a segment to the end of the buffer. The timer is started
+     * the first time a segment is added.
+     * @param segment is the segment being added
+     * @return is false if the buffer is full, otherwise true is returned
+     */
+    bool addSegment(StepSegment* segment);
+
+    /**
+     * Used to determine if the engine is able to take another segment
+     * @return is true if the buffer has a free slot, otherwise false is returned
+     */
+    bool isReady();
+
+    /**
+     * Used to get the number of segments waiting in the buffer
+     * @return is the number of buffered segments
+     */
+    uint8_t getBufferedSegments();
+
+    /**
+     * Used to determine if the engine has finished all of its segments
+     * @return is true if there are no segments left to perform, otherwise false is returned
+     */
+    bool isIdle();
+
+    /**
+     * This function is used to write the direction pins of all motors at once. It should only
+     * be called while the engine is idle, segments carry their own directions.
+     */
+    void writeDirections();
+
+    /** This function is used to drop the current segment and every buffered segment */
+    void stop();
+
+    /**
+     * This function is used to run the timer when there are no timer interrupts (computer builds).
+     * It does nothing on the microcontroller.
+     */
+    void poll();
+};
@@ -0,0 +1,98 @@
+/**
+ * This file contains the step output layer. Instead of writing each step and direction pin on
+ * its own, the pins of all axes that share a GPIO port are written together with a single write
+ * to the set and clear registers of the port (DR_SET/DR_CLEAR on the i.MX RT).
+ *
+ * @author Thomas Batchelder
+ * @file StepOutput.h
+ * @date 10/17/2026 - File created
+ */
+
+#pragma once
+#include "AxisConfig.h"
+#include "Configuration.h"
+#include "Hal.h"
+
+/** Maximum number of GPIO ports used by the step and direction pins */
+#define MAX_OUTPUT_PORTS (2 * DOF)
+
+/**
+ * A GPIO port used by the step output. On the microcontroller the port is written through its
+ * set and clear registers, on a computer the port is one of the mocked ports.
+ */
+struct OutputPort {
+#ifdef ARDUINO
+    /** Register that sets every pin of the written mask high */
+    volatile uint32_t* setRegister;
+    /** Register that sets every pin of the written mask low */
+    volatile uint32_t* clearRegister;
+#else
+    /** Mocked port being written */
+    HostGpioPort* hostPort;
+#endif
+};
+
+/**
+ * This class is used to write the step and direction pins of all axes. The ports of the pins
+ * are found once when the output is constructed so every write only has to combine bitmasks.
+ */
+class StepOutput {
+protected:
+    /** Ports used by the step and direction pins */
+    OutputPort ports[MAX_OUTPUT_PORTS];
+    /** Number of ports used */
+    uint8_t portCount = 0;
+
+    /** Index of the port used by the step pin of each axis */
+    uint8_t stepPort[DOF];
+    /** Bit of the step pin of each axis within its port */
+    uint32_t stepBit[DOF];
+    /** Index of the port used by the direction pin of each axis */
+    uint8_t dirPort[DOF];
+    /** Bit of the direction pin of each axis within its port */
+    uint32_t dirBit[DOF];
+
+    /**
+     * This function is used to find the port of a pin, the port is added if it is not used yet
+     * @param pin is the pin whose port is being found
+     * @return is the index of the port
+     */
+    uint8_t findPort(uint8_t pin);
+
+    /**
+     * This function is used to write to the set registers of the ports
+     * @param portMasks is the mask of pins to set high for each port
+     */
+    void writeSet(uint32_t* portMasks);
+
+    /**
+     * This function is used to write to the clear registers of the ports
+     * @param portMasks is the mask of pins to set low for each port
+     */
+    void writeClear(uint32_t* portMasks);
+
+public:
+    /**
+     * Used to construct the step output
+     * @param stepPins is the step pin of each axis
+     * @param dirPins is the direction pin of each axis
+     */
+    StepOutput(uint8_t* stepPins, uint8_t* dirPins);
+
+    /** Default Constructor */
+    StepOutput() { }
+
+    /**
+     * This function is used to send one step pulse to every axis in the mask. All axes share
+     * the same pulse width wait.
+     * @param axisMask has bit i set if axis i + 1 is stepping
+     */
+    void pulse(uint8_t axisMask);
+
+    /**
+     * This function is used to write the direction pins of all axes at once. The inverted axes of
+     * Configuration.h (INVERT_DIR) are applied here with a mask worked out at compile time.
+     * @param counterClockwiseMask has bit i set if axis i + 1 is moving counterclockwise
+     */
+    void writeDirections(uint8_t counterClockwiseMask);
+};
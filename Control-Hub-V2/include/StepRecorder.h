@@ -0,0 +1,93 @@
+/**
+ * This file contains the step recorder used by the benchmarks. When the firmware is built with
+ * RUN_BENCHMARKS the step engine hands every timer interrupt of a segment to the recorder, which
+ * keeps the time of the interrupt, the axes that stepped and the step interval the interrupt was
+ * scheduled with. On the microcontroller the time comes from the cycle counter, on a computer it
+ * comes from the virtual clock.
+ *
+ * @author Thomas Batchelder
+ * @file StepRecorder.h
+ * @date 10/17/2026 - File created
+ */
+
+#pragma once
+#include "Configuration.h"
+#include "Hal.h"
+
+/** A single interrupt of the step engine */
+struct StepEdge {
+    /** Time of the interrupt in ticks of the timestamp source */
+    uint32_t time;
+    /** Step interval the interrupt was scheduled with in microseconds */
+    float interval;
+    /** Axes that stepped during the interrupt, bit i is set if axis i + 1 stepped */
+    uint8_t axisMask;
+};
+
+/**
+ * This class is used to record the step edges sent by the step engine. Only one recorder can
+ * be active at a time, the step engine forwards every interrupt to the active recorder.
+ */
+class StepRecorder {
+protected:
+    /** Recorded edges in the order they were sent */
+    StepEdge edges[BENCHMARK_MAX_STEP_EDGES];
+    /** Number of recorded edges */
+    volatile uint32_t edgeCount = 0;
+    /** Number of edges that did not fit in the buffer */
+    volatile uint32_t droppedEdges = 0;
+
+    /** The recorder that edges are currently sent to */
+    static StepRecorder* activeRecorder;
+
+public:
+    /**
+     * This function is used to get the current time of the timestamp source
+     * @return is the time in ticks (CPU cycles on the microcontroller, nanoseconds on a computer)
+     */
+    static uint32_t timestamp();
+
+    /**
+     * This function is used to get the resolution of the timestamp source
+     * @return is the number of ticks in a microsecond
+     */
+    static double ticksPerMicrosecond();
+
+    /**
+     * This function is used to get the number of ticks the processor has run for. Unlike timestamp()
+     * it keeps moving on a computer while the virtual clock is stopped, so it can time code.
+     * @return is the time in ticks (CPU cycles on the microcontroller, nanoseconds on a computer)
+     */
+    static uint32_t cycleCount();
+
+    /**
+     * This function is called by the step engine on every interrupt of a segment
+     * @param axisMask is the mask of the axes that stepped
+     * @param interval is the step interval the interrupt was scheduled with
+     */
+    static void record(uint8_t axisMask, float interval);
+
+    /** This function is used to clear the recorder and start recording edges */
+    void start();
+
+    /** This function is used to stop recording edges */
+    void stop();
+
+    /**
+     * This function is used to get the recorded edges
+     * @return is the array of edges
+     */
+    StepEdge* getEdges();
+
+    /**
+     * This function is used to get the number of recorded edges
+     * @return is the number of edges
+     */
+    uint32_t getEdgeCount();
+
+    /**
+     * This function is used to get the number of edges that did not fit in the buffer
+     * @return is the number of dropped edges
+     */
+    uint32_t getDroppedEdges();
+};
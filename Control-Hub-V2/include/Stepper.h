@@ -10,10 +10,23 @@
  */
 
 #pragma once
+#include "AxisConfig.h"
 #include "Configuration.h"
+#include "LimitSwitchSampler.h"
 #include "Util.h"
-#include <Arduino.h>
-#include <Encoder.h>
+#include "Hal.h"
+
+/**
+ * Reading of every encoder taken together, so that all axes are compared at the same point in time
+ */
+struct EncoderSnapshot {
+    /** Raw count of each encoder */
+    int32_t counts[DOF];
+    /** Position of each encoder in motor steps */
+    int32_t steps[DOF];
+    /** Point in time when the snapshot was taken in microseconds */
+    uint32_t timeStamp;
+};
 
 /**
  * Main stepper motor class that contains all information to get the Arduino to move a stepper
@@ -27,6 +40,8 @@ protected:
     uint8_t dirPin;
     /** Pin used to determine if the motor has reached its limit */
     uint8_t limPin;
+    /** Background sampler of the limit switches (the switch is read directly if there is none) */
+    LimitSwitchSampler* limitSwitches = NULL;
 
     /** The amount of microsteps required to complete one rotation */
     int32_t microsteping;
@@ -35,12 +50,12 @@ protected:
 
     /** Maximum position that the motor can travel to in steps */
     int32_t maxMotorPosition;
-    /** The current position of the motor in steps */
-    int32_t currentPosition;
+    /** The current position of the motor in steps (updated by the step engine interrupt) */
+    volatile int32_t currentPosition;
     /** The amount of degrees the axis changes with each step */
     double degreeChangePerStep;
 
-    /** Used to reverse the motor direction for default */
+    /** Used to reverse the motor direction for default (the step engine uses INVERT_DIR of Configuration.h instead) */
     bool invertMotorDirection;
     /** Current direction the axis is spinning (true for counterclosewise)*/
     bool counterClockwise;
@@ -49,15 +64,46 @@ protected:
     Encoder* encoder;
     /** The maximum allowable difference between motor position and encoder position */
     int32_t encoderThreshold;
+    /** Encoder counts are turned into motor steps by multiplying by this numerator... */
+    int32_t encoderStepsNumerator;
+    /** ...and dividing by this denominator (microsteping / ENCODER_CPR reduced) */
+    int32_t encoderStepsDenominator;
     /** Used to determine if crash detection will be used with the motor */
     bool enableCrashDetection;
+    /** Fastest the axis is allowed to move in degrees per microsecond (0 is no limit) */
+    double maxVelocity = 0;
+    /** Largest acceleration the axis is allowed in degrees per microsecond squared (0 is no limit) */
+    double maxAcceleration = 0;
 
     /** This field can be used to disable the motor and won't allow for any movement */
-    bool disable;
+    volatile bool disable;
 
     /** This is the axis the motor is connected to */
     int axis;
 
+    /**
+     * This method is used to initialize the motor with values that have already been derived
+     * from its settings. See the public constructor for the other parameters.
+     * @param degreeChangePerStep       -Degrees the axis moves with each step
+     * @param encoderStepsNumerator     -Numerator of the reduced microsteping / ENCODER_CPR ratio
+     * @param encoderStepsDenominator   -Denominator of the reduced microsteping / ENCODER_CPR ratio
+     */
+    Stepper(
+        uint8_t stepPin,
+        uint8_t dirPin,
+        uint8_t limPin,
+        Encoder* encoder,
+        int32_t microsteping,
+        double gearReduction,
+        int32_t maxPosition,
+        bool reverseDir,
+        int32_t encoderThreshold,
+        int axis,
+        bool enableCrashDetection,
+        double degreeChangePerStep,
+        int32_t encoderStepsNumerator,
+        int32_t encoderStepsDenominator);
+
 public:
     /**
      * This method is used to initialize the motor.
@@ -81,13 +127,42 @@ public:
         double gearReduction,
         int32_t maxPosition,
         bool reverseDir,
-        int32_t encoderThreshole,
+        int32_t encoderThreshold,
         int axis,
         bool enableCrashDetection);
 
     /** Default contstructor for Stepper */
     Stepper() { }
 
+    /**
+     * This method is used to initialize the motor of an axis from its description in Configuration.h.
+     * Every setting of the axis is a compile time constant, including the values derived from them.
+     * @param encoder is the encoder the motor will be using
+     * @return is the motor of the axis
+     */
+    template <int axis>
+    static Stepper fromConfig(Encoder* encoder)
+    {
+        typedef AxisConfig<axis> Config;
+        Stepper motor(
+            Config::stepPin,
+            Config::dirPin,
+            Config::limPin,
+            encoder,
+            Config::microsteping,
+            Config::gearReduction,
+            Config::maxPosition,
+            Config::invertDir,
+            Config::encoderThreshold,
+            axis,
+            Config::crashDetection,
+            Config::degreeChangePerStep,
+            Config::stepsNumerator,
+            Config::stepsDenominator);
+        motor.setMotionLimits(Config::maxVelocity, Config::maxAcceleration);
+        return motor;
+    }
+
     /**
      * This function is used to send a pulse to the steppers step pin. If the motor is at it's max
      * position or the motor is on the limit switch traveling counterclockwise then false is returned
@@ -95,6 +170,40 @@ public:
      * */
     bool pulse();
 
+    /**
+     * This function is used to update the position of the motor for one step without sending the
+     * pulse. The step engine uses it to send the pulses of all axes together. If the motor is at it's
+     * max position or the motor is on the limit switch traveling counterclockwise then false is returned
+     * @return is true if the pulse should be sent, otherwise false is returned
+     */
+    bool takeStep();
+
+    /**
+     * This function is the same as takeStep() for a motor built by fromConfig(), it is used by the step
+     * engine interrupt. The settings of the axis are taken from Config so they are constants, only the
+     * state of the motor (position, direction and the disable flag set while homing) is read from it.
+     * @return is true if the pulse should be sent, otherwise false is returned
+     */
+    template <class Config>
+    inline bool takeStep()
+    {
+        if (this->disable)
+            return false;
+        if (this->counterClockwise) {
+            if (this->limitSwitches != NULL) {
+                if (this->limitSwitches->isPressed(Config::axis))
+                    return false;
+            } else if (digitalReadFast(Config::limPin) && limitSwitchFilter(Config::limPin, 20, 0.75)) {
+                return false;
+            }
+        }
+        int32_t position = this->currentPosition + (this->counterClockwise ? -1 : 1);
+        if (Config::maxPosition != UNLIMITED_ROTATIONS && position > Config::maxPosition)
+            return false;
+        this->currentPosition = position;
+        return true;
+    }
+
     /** This function is used to get information about the motor as String */
     String toString();
 
@@ -104,6 +213,26 @@ public:
      */
     bool comparePositionToEncoder();
 
+    /**
+     * This function compares the position if the motor to an encoder position that has already been read
+     * @param encoderSteps is the position of the encoder in motor steps (see EncoderSnapshot)
+     * @return is true if the motor's position matches the encoder within thershold, otherwise false if returned
+     */
+    bool comparePositionToEncoder(int32_t encoderSteps);
+
+    /**
+     * This function is used to turn a raw encoder count into motor steps using integer math
+     * @param counts is the raw encoder count
+     * @return is the encoder position in motor steps
+     */
+    int32_t encoderCountsToSteps(int32_t counts);
+
+    /**
+     * This function is used to get the encoder used by the motor
+     * @return is a pointer to the encoder
+     */
+    Encoder* getEncoder();
+
     /**
      * This function is used to read the current position of the encoder
      * @return is the current position of the encoder
@@ -118,11 +247,18 @@ public:
 
     /**
      * This function is used to read the current position of the limit switch (true/false) 
-     * This function does the limit switch filter to determine the state of the switch
+     * The debounced state from the limit switch sampler is used if the motor has one, otherwise
+     * this function does the limit switch filter to determine the state of the switch
      * @return is the current state of the limit switch
      */
     bool readLimitSwitch();
 
+    /**
+     * This function is used to give the motor the sampler that debounces its limit switch
+     * @param limitSwitches is the limit switch sampler
+     */
+    void setLimitSwitchSampler(LimitSwitchSampler* limitSwitches);
+
     /**
      * This function is used to get the current direction the motor is moving in
      * @return is true if the motor is traveling counter clockwise, other false is returned
@@ -132,8 +268,27 @@ public:
     /**
      * This function is used to set the direction of the motor
      * @param counterClockwise is true if the motor is to spin counter clockwise
+     * @param writePin is false if the direction pin will be written by the step engine together with the other axes
+     */
+    void setDirection(bool counterClockwise, bool writePin = true);
+
+    /**
+     * This function is used to get the level of the direction pin for the current direction
+     * @return is true if the direction pin is high, otherwise false is returned
+     */
+    bool getDirectionPinLevel();
+
+    /**
+     * This function is used to get the step pin of the motor
+     * @return is the step pin
+     */
+    uint8_t getStepPin();
+
+    /**
+     * This function is used to get the direction pin of the motor
+     * @return is the direction pin
      */
-    void setDirection(bool counterClockwise);
+    uint8_t getDirPin();
 
     /**
      * This function is used to get the current position of the motor in motor steps
@@ -189,4 +344,41 @@ public:
      * @return is true if it is enable, otherwise false is returned
      */
     bool isCrashDetectionEnabled();
-};
\ No newline at end of file
+
+    /**
+     * This function is used to turn crash detection on or off
+     * @param enable is true if crash detection should be enabled
+     */
+    void setCrashDetection(bool enable);
+
+    /**
+     * This function is used to set how fast the axis is allowed to move. Movements are slowed down
+     * so that the axis stays within its limits.
+     * @param maxVelocity is the fastest the axis can move in degrees per microsecond (0 is no limit)
+     * @param maxAcceleration is the largest acceleration of the axis in degrees per microsecond squared (0 is no limit)
+     */
+    void setMotionLimits(double maxVelocity, double maxAcceleration);
+
+    /**
+     * This function is used to get the fastest the axis is allowed to move
+     * @return is the velocity limit in degrees per microsecond (0 is no limit)
+     */
+    double getMaxVelocity();
+
+    /**
+     * This function is used to get the largest acceleration the axis is allowed
+     * @return is the acceleration limit in degrees per microsecond squared (0 is no limit)
+     */
+    double getMaxAcceleration();
+};
+
+/**
+ * This function is used to read the encoders of all motors at once. The counts kept by the encoder
+ * interrupts are loaded in a single critical section (Encoder::read() is not used since it turns
+ * interrupts back on), so every axis is read at the same point in time. The scaling to motor steps is
+ * done after the loads so interrupts are only off for the loads. The encoders are found from the
+ * pins in Configuration.h (ENCODER_1_PINS to ENCODER_6_PINS).
+ * @param motors is the array of all motors
+ * @param snapshot is where the reading is stored
+ */
+void readEncoderSnapshot(Stepper* motors, EncoderSnapshot* snapshot);
\ No newline at end of file
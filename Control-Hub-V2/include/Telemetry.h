@@ -0,0 +1,124 @@
+/**
+ * This file contains the telemetry sender. At a fixed rate it packs the state of the arm into a
+ * binary frame (see Framing.h) and leaves it in a ring, the ring is only written to the serial
+ * port while the port has room for a whole frame, so the motion loop is never held up by it. Each
+ * crash the event queue recovers from is sent the same way in a frame of its own.
+ *
+ * @author Thomas Batchelder
+ * @file Telemetry.h
+ * @date 10/17/2026 - File created
+ */
+
+#pragma once
+#include "Configuration.h"
+#include "EventQueue.h"
+#include "Framing.h"
+#include "SpscRing.h"
+#include "Stepper.h"
+#include "Hal.h"
+
+class Communication;
+
+/**
+ * Size in bytes of a telemetry frame before the CRC, all values are little endian: uint8 type
+ * (FRAME_TELEMETRY), uint16 sequence, uint32 time in microseconds, 6 int32 motor positions, 6 int32
+ * encoder positions and 6 int32 following errors (motor - encoder) in steps, uint16 queue depth,
+ * uint16 buffered setpoints, uint16 loops, uint32 longest loop in microseconds, uint8 error flags
+ */
+#define TELEMETRY_FRAME_SIZE (1 + 2 + 4 + 3 * DOF * 4 + 2 + 2 + 2 + 4 + 1)
+/**
+ * Size in bytes of a crash recovery frame before the CRC (see CrashRecovery): uint8 type
+ * (FRAME_CRASH_RECOVERY), uint32 count, uint8 axis, int32 motor steps, int32 encoder steps, uint32
+ * detected at in microseconds, uint32 deceleration time and uint32 settle time in microseconds,
+ * float32 new velocity in degrees per microsecond
+ */
+#define TELEMETRY_RECOVERY_SIZE (1 + 4 + 1 + 4 + 4 + 4 + 4 + 4 + 4)
+/** Most bytes a telemetry frame takes in the ring once it is encoded, with a delimiter before and after it */
+#define TELEMETRY_ENCODED_SIZE FRAME_ENCODED_SIZE(TELEMETRY_FRAME_SIZE)
+
+/** Error flags of a telemetry frame, the flags marked as "since" are about the time since the last frame */
+#define TELEMETRY_FOLLOWING_ERROR 0x01 // An axis is further from its encoder than its crash threshold
+#define TELEMETRY_CRASH_RECOVERY 0x02 // The arm is recovering from a crash
+#define TELEMETRY_STREAM_UNDERRUN 0x04 // A stream ran out of setpoints since
+#define TELEMETRY_FRAME_ERROR 0x08 // A frame from the computer was damaged since
+#define TELEMETRY_EVENT_REJECTED 0x10 // An event did not fit in the queue since
+#define TELEMETRY_FRAMES_DROPPED 0x20 // Telemetry frames were dropped since, as the ring was full
+
+static_assert(TELEMETRY_ENCODED_SIZE <= 0xFF, "The length of an encoded frame is kept in one byte of the ring");
+static_assert(TELEMETRY_ENCODED_SIZE < TELEMETRY_TX_BUFFER_SIZE, "A telemetry frame has to fit in the ring");
+static_assert(TELEMETRY_RECOVERY_SIZE <= TELEMETRY_FRAME_SIZE, "A crash recovery frame is encoded like a telemetry frame");
+
+/**
+ * This class is used to send the state of the arm to the computer at a fixed rate. Each frame
+ * starts and ends with a frame delimiter, which never appears in the text lines, so the computer
+ * can tell the frames apart from the replies.
+ */
+class Telemetry {
+protected:
+    /** Encoded frames waiting to be sent, each frame is held after one byte giving its length */
+    SpscRing<uint8_t, TELEMETRY_TX_BUFFER_SIZE> transmit;
+    /** Pointer to an array of all the motors in the robot */
+    Stepper* motors;
+    /** Event queue the depth and errors are read from */
+    EventQueue* eventQueue;
+    /** Communication the frame errors are read from */
+    Communication* communication;
+    /** Time between frames in microseconds, 0 if telemetry is off */
+    uint32_t period;
+    /** Point in time when the last frame was due */
+    uint32_t frameTime;
+    /** Sequence number of the next frame */
+    uint16_t sequence;
+    /** Point in time when the last loop started, and used to determine if there has been a loop yet */
+    uint32_t loopTime;
+    bool hasLooped;
+    /** Number of loops and the longest loop in microseconds since the last frame */
+    uint32_t loops, longestLoop;
+    /** Counts of the errors at the last frame, a flag is set when a count has gone up since */
+    uint32_t streamUnderruns, frameErrors, rejectedEvents;
+    /** Used to determine if a frame was dropped since the last frame */
+    bool framesDropped;
+    /** Number of crash recoveries that have been sent to the computer */
+    uint32_t reportedRecoveries;
+
+    /** This function is used to pack the state of the arm into a frame and add it to the ring */
+    void queueFrame();
+
+    /**
+     * This function is used to pack the last crash the event queue recovered from into a frame and add
+     * it to the ring. It is sent whatever the rate, and is tried again next loop if the ring is full.
+     */
+    void queueCrashRecovery();
+
+    /**
+     * This function is used to encode a frame and add it to the ring
+     * @param frame is the frame, starting with its type. It needs room for the CRC after its length
+     * @param length is the number of bytes in the frame
+     * @return is false if the ring has no room for the frame, otherwise true is returned
+     */
+    bool addFrame(uint8_t* frame, uint32_t length);
+
+    /** This function is used to write the frames in the ring while the serial port has room for them */
+    void sendFrames();
+
+public:
+    /**
+     * Used to construct a new telemetry sender
+     * @param motors is a pointer to an array of all the motors in the robot
+     * @param eventQueue is the event queue used by the controller
+     * @param communication is the communication used by the controller
+     */
+    Telemetry(Stepper* motors, EventQueue* eventQueue, Communication* communication);
+
+    /** Default Constructor */
+    Telemetry() { }
+
+    /** This function is designed to be run once every main loop, it times the loop and sends the frames that are due */
+    void update();
+
+    /**
+     * This function is used to set the number of frames sent each second
+     * @param rate is the number of frames each second (limited to TELEMETRY_MAX_RATE), 0 turns telemetry off
+     */
+    void setRate(uint32_t rate);
+};
@@ -6,9 +6,9 @@
  * @date 1/19/2021 - created file
  */
 
+#pragma once
 #include "Configuration.h"
-#include <Encoder.h>
-#include <Arduino.h>
+#include "Hal.h"
 
 /** 
  * This function is useful for testing the limit switches
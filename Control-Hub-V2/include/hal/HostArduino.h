@@ -0,0 +1,305 @@
+/**
+ * This file contains the stand-ins for the Arduino API used when the motion core is built on a
+ * computer. Only the parts of the API that the arm uses are provided. Along with the Arduino
+ * functions there are host only functions used to drive the virtual hardware (moving the virtual
+ * clock, feeding the virtual serial port and reading back what was written to it).
+ *
+ * @author Thomas Batchelder
+ * @file HostArduino.h
+ * @date 10/17/2026 - File created
+ */
+
+#pragma once
+#ifndef ARDUINO
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+/** Number of pins on the Teensy 4.1 */
+#define HOST_PIN_COUNT 64
+/** Number of mocked GPIO ports, each port holds 32 pins */
+#define HOST_GPIO_PORTS (HOST_PIN_COUNT / 32)
+/** Maximum number of timers that can run at once (the Teensy has 4 PIT channels) */
+#define HOST_MAX_TIMERS 4
+/** Time the virtual clock moves for each main loop when the serial port is bridged (HOST_SERIAL_BRIDGE) */
+#define HOST_BRIDGE_LOOP_MICROSECONDS 10
+
+template <class A, class B>
+inline typename std::common_type<A, B>::type min(A a, B b) { return (b < a) ? b : a; }
+template <class A, class B>
+inline typename std::common_type<A, B>::type max(A a, B b) { return (a < b) ? b : a; }
+template <class T>
+inline T sq(T x) { return x * x; }
+
+inline void noInterrupts() { }
+inline void interrupts() { }
+inline void __disable_irq() { }
+inline void __enable_irq() { }
+
+// +---------------------------------------------------+ //
+// |               --- Virtual Clock ---               | //
+// +---------------------------------------------------+ //
+
+class IntervalTimer;
+
+/**
+ * The virtual clock is used for micros(), millis() and the delays. By default it follows the real
+ * time of the computer and the timers are run whenever they are polled. In manual mode time only
+ * moves when advance() is called (or a delay is used), and every timer is run at exactly the point
+ * in time when it is due, the same way the timer interrupts run on the microcontroller.
+ */
+class HostClock {
+protected:
+    /** Current time of the clock in microseconds */
+    double currentTime = 0;
+    /** Used to determine if time only moves when advance() is called */
+    bool manual = false;
+    /** Used to determine if a timer callback is currently running */
+    bool inInterrupt = false;
+    /** Timers that are currently running */
+    IntervalTimer* timers[HOST_MAX_TIMERS] = { NULL };
+
+public:
+    /**
+     * This function is used to get the real time passed since the program started
+     * @return is the real time in microseconds
+     */
+    double realTime();
+
+    /**
+     * This function is used to get the current time of the clock
+     * @return is the current time in microseconds
+     */
+    double now();
+
+    /**
+     * This function is used to switch between real time and manual mode
+     * @param manual is true if time should only move when advance() is called
+     */
+    void setManual(bool manual);
+
+    /**
+     * This function is used to move the clock forward, running every timer that becomes due
+     * @param microseconds is the amount of time to move forward
+     */
+    void advance(double microseconds);
+
+    /**
+     * This function is used to run every timer that is due up to a point in time
+     * @param until is the point in time in microseconds
+     */
+    void runTimers(double until);
+
+    /** This function is used to catch the clock up with real time (it does nothing in manual mode) */
+    void update();
+
+    /**
+     * Used to determine if a timer callback is currently running
+     * @return is true if a timer callback is running, otherwise false is returned
+     */
+    bool isInInterrupt();
+
+    /**
+     * This function is used to add a timer to the clock
+     * @param timer is the timer being added
+     * @return is false if there are already HOST_MAX_TIMERS timers, otherwise true is returned
+     */
+    bool addTimer(IntervalTimer* timer);
+
+    /**
+     * This function is used to remove a timer from the clock
+     * @param timer is the timer being removed
+     */
+    void removeTimer(IntervalTimer* timer);
+
+    /**
+     * This function is used to wait for an amount of time. In manual mode the clock is advanced,
+     * inside a timer callback the clock moves without running other timers.
+     * @param microseconds is the amount of time to wait
+     */
+    void wait(double microseconds);
+};
+
+/** The virtual clock */
+extern HostClock hostClock;
+
+uint32_t micros();
+uint32_t millis();
+void delay(uint32_t milliseconds);
+void delayMicroseconds(uint32_t microseconds);
+
+// +---------------------------------------------------+ //
+// |                 --- Mock GPIO ---                 | //
+// +---------------------------------------------------+ //
+
+/** Mock of a GPIO port */
+struct HostGpioPort {
+    /** Current level of each pin of the port */
+    uint32_t state;
+    /** Number of writes to the set register */
+    uint32_t setCount;
+    /** Number of writes to the clear register */
+    uint32_t clearCount;
+};
+
+/** The mocked GPIO ports, pin p is bit (p % 32) of port (p / 32) */
+extern HostGpioPort hostGpioPorts[HOST_GPIO_PORTS];
+
+/**
+ * This function is used to set pins of a port high, the same as a write to DR_SET
+ * @param port is the port being written
+ * @param mask is the mask of pins being set
+ */
+void hostGpioSet(HostGpioPort* port, uint32_t mask);
+
+/**
+ * This function is used to set pins of a port low, the same as a write to DR_CLEAR
+ * @param port is the port being written
+ * @param mask is the mask of pins being cleared
+ */
+void hostGpioClear(HostGpioPort* port, uint32_t mask);
+
+/**
+ * This function is used to get the port of a pin
+ * @param pin is the pin
+ * @return is the mocked port of the pin
+ */
+HostGpioPort* hostPinPort(uint8_t pin);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int digitalReadFast(uint8_t pin);
+
+// +---------------------------------------------------+ //
+// |                   --- String ---                  | //
+// +---------------------------------------------------+ //
+
+/** Stand-in for the Arduino String class */
+class String {
+protected:
+    /** Text of the string */
+    std::string text;
+
+public:
+    String() { }
+    String(const char* text) : text(text) { }
+    String(const std::string& text) : text(text) { }
+    String(char value) : text(1, value) { }
+    String(unsigned char value) : text(std::to_string(value)) { }
+    String(int value) : text(std::to_string(value)) { }
+    String(unsigned int value) : text(std::to_string(value)) { }
+    String(long value) : text(std::to_string(value)) { }
+    String(unsigned long value) : text(std::to_string(value)) { }
+    String(long long value) : text(std::to_string(value)) { }
+    String(unsigned long long value) : text(std::to_string(value)) { }
+    String(double value, unsigned char decimalPlaces = 2);
+
+    const char* c_str() const { return this->text.c_str(); }
+    unsigned int length() const { return this->text.length(); }
+    int compareTo(const String& other) const { return this->text.compare(other.text); }
+    String& operator+=(const String& other);
+    friend String operator+(const String& a, const String& b);
+    friend String operator+(const String& a, const char* b);
+};
+
+// +---------------------------------------------------+ //
+// |               --- Virtual Serial ---              | //
+// +---------------------------------------------------+ //
+
+/**
+ * Stand-in for the USB serial port. Bytes sent by the computer are added with inject(), everything
+ * written by the arm is kept until it is taken with takeOutput() and is echoed to stdout by default.
+ * The port can also be bridged to stdin and stdout (see setStdio()), so Controller.py can talk to the
+ * arm through a pipe.
+ */
+class HostSerial {
+protected:
+    /** Bytes waiting to be read */
+    std::string input;
+    /** Index of the next byte to be read */
+    size_t readIndex = 0;
+    /** Bytes written that have not been taken yet */
+    std::string output;
+    /** Used to determine if written bytes are also printed to stdout */
+    bool echo = true;
+    /** Used to determine if the port is bridged to stdin and stdout, and if stdin has not been closed */
+    bool stdio = false;
+    bool stdinOpen = true;
+
+    /** This function is used to add the bytes waiting on stdin without blocking */
+    void readStdin();
+
+public:
+    void begin(uint32_t baudrate) { }
+    int available();
+    int read();
+    size_t readBytes(char* buffer, size_t length);
+    int availableForWrite();
+    size_t write(uint8_t value);
+    size_t write(const uint8_t* buffer, size_t length);
+
+    size_t print(const char* text);
+    size_t print(const String& text) { return print(text.c_str()); }
+    size_t print(char value) { return write((uint8_t)value); }
+    size_t print(unsigned char value) { return print(String(value)); }
+    size_t print(int value) { return print(String(value)); }
+    size_t print(unsigned int value) { return print(String(value)); }
+    size_t print(long value) { return print(String(value)); }
+    size_t print(unsigned long value) { return print(String(value)); }
+    size_t print(long long value) { return print(String(value)); }
+    size_t print(unsigned long long value) { return print(String(value)); }
+    size_t print(double value, int digits = 2) { return print(String(value, digits)); }
+
+    size_t println() { return print("\r\n"); }
+    template <class T>
+    size_t println(T value) { return print(value) + println(); }
+
+    /**
+     * This function is used to add bytes sent by the computer
+     * @param data is the bytes being added
+     * @param length is the number of bytes
+     */
+    void inject(const uint8_t* data, size_t length);
+
+    /**
+     * This function is used to take everything written since the last call
+     * @return is the written bytes
+     */
+    std::string takeOutput();
+
+    /**
+     * This function is used to turn the echo of written bytes to stdout on or off
+     * @param echo is true if written bytes should be printed
+     */
+    void setEcho(bool echo) { this->echo = echo; }
+
+    /**
+     * This function is used to bridge the port to stdin and stdout. The bytes on stdin are read as
+     * they arrive, and every written byte goes straight to stdout (whatever the echo) rather than
+     * being kept for takeOutput().
+     * @param stdio is true if the port should be bridged
+     */
+    void setStdio(bool stdio) { this->stdio = stdio; }
+
+    /**
+     * Used to determine if the computer can still send bytes while the port is bridged
+     * @return is false once stdin has been closed, otherwise true is returned
+     */
+    bool isStdinOpen() { return this->stdinOpen; }
+};
+
+/** The virtual serial port */
+extern HostSerial Serial;
+
+#endif
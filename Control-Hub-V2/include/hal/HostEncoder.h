@@ -0,0 +1,95 @@
+/**
+ * This file contains the virtual encoder used when the motion core is built on a computer.
+ * A virtual encoder can follow the step and direction pins of a motor so that the encoder
+ * position tracks the steps sent to the motor, the same as an encoder on the real arm.
+ *
+ * @author Thomas Batchelder
+ * @file HostEncoder.h
+ * @date 10/17/2026 - File created
+ */
+
+#pragma once
+#ifndef ARDUINO
+
+#include "HostArduino.h"
+
+/**
+ * This function is used to let the mock GPIO send step edges to a virtual encoder
+ * @param encoder is the encoder following a motor
+ */
+void hostAttachEncoder(class Encoder* encoder);
+
+/**
+ * This function is used to stop sending step edges to a virtual encoder
+ * @param encoder is the encoder
+ */
+void hostDetachEncoder(class Encoder* encoder);
+
+/** Stand-in for the Encoder library */
+class Encoder {
+protected:
+    /** Current count of the encoder */
+    int32_t position = 0;
+    /** Steps taken by the followed motor since the position was last written */
+    int32_t stepCount = 0;
+    /** Count of the encoder when the position was last written */
+    int32_t positionOffset = 0;
+    /** Step pin of the followed motor (-1 if the encoder does not follow a motor) */
+    int16_t stepPin = -1;
+    /** Direction pin of the followed motor */
+    uint8_t dirPin = 0;
+    /** Level of the direction pin when the encoder counts up */
+    bool countUpLevel = true;
+    /** Counts per revolution of the encoder */
+    int32_t countsPerRevolution = 1;
+    /** Steps per revolution of the followed motor */
+    int32_t stepsPerRevolution = 1;
+
+public:
+    Encoder(uint8_t pin1, uint8_t pin2) { }
+    ~Encoder();
+
+    int32_t read() { return this->position; }
+    int32_t readAndReset();
+    void write(int32_t position);
+
+    /**
+     * This function is used to make the encoder follow the step and direction pins of a motor
+     * @param stepPin is the step pin of the motor
+     * @param dirPin is the direction pin of the motor
+     * @param countUpLevel is the level of the direction pin when the encoder counts up
+     * @param countsPerRevolution is the number of counts per revolution of the encoder
+     * @param stepsPerRevolution is the number of steps per revolution of the motor
+     */
+    void followStepper(uint8_t stepPin, uint8_t dirPin, bool countUpLevel, int32_t countsPerRevolution, int32_t stepsPerRevolution);
+
+    /**
+     * This function is used by the mock GPIO when the step pin of the followed motor goes high
+     * @param dirLevel is the level of the direction pin
+     */
+    void onStep(bool dirLevel);
+
+    /**
+     * This function is used to get the step pin of the followed motor
+     * @return is the step pin, or -1 if the encoder does not follow a motor
+     */
+    int16_t getStepPin() { return this->stepPin; }
+
+    /**
+     * This function is used to get the direction pin of the followed motor
+     * @return is the direction pin
+     */
+    uint8_t getDirPin() { return this->dirPin; }
+
+    /**
+     * This function is used to get the count that the step edges keep up to date, like the count kept
+     * by the interrupt of the Encoder library
+     * @return is the count of the encoder
+     */
+    volatile int32_t* getCount() { return &this->position; }
+};
+
+/** Stand-in for getEncoderCount() of Hal.h, the count of a virtual encoder is found from the encoder itself */
+inline volatile int32_t* getEncoderCount(Encoder* encoder, uint8_t pin) { return encoder->getCount(); }
+
+#endif
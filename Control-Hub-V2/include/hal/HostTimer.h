@@ -0,0 +1,62 @@
+/**
+ * This file contains a stand-in for the Teensy IntervalTimer. It is used when the motion core
+ * is built on a computer, on the microcontroller the IntervalTimer from the Teensy core is used.
+ *
+ * @author Thomas Batchelder
+ * @file HostTimer.h
+ * @date 10/17/2026 - File created
+ */
+
+#pragma once
+#ifndef ARDUINO
+
+#include "HostArduino.h"
+
+/**
+ * Stand-in for the Teensy IntervalTimer when the motion core is built on a computer.
+ * There are no timer interrupts on the host, so the callbacks are run by the virtual clock.
+ * In real time mode that happens whenever poll() is called, in manual mode it happens while
+ * the clock is advanced.
+ */
+class IntervalTimer {
+protected:
+    /** Function that is called every period */
+    void (*callback)() = NULL;
+    /** Period of the timer in microseconds */
+    double period = 0;
+    /** Point in time when the callback is next run */
+    double deadline = 0;
+
+public:
+    IntervalTimer() { }
+    /** A copied timer is not running, the same as a timer that has not been started */
+    IntervalTimer(const IntervalTimer& other) { }
+    IntervalTimer& operator=(const IntervalTimer& other) { return *this; }
+    ~IntervalTimer() { end(); }
+
+    /**
+     * This function is used to start the timer. Calling it while the timer is running
+     * restarts the timer with the new period.
+     * @param funct is the function called every period
+     * @param microseconds is the period of the timer
+     * @return is false if there are no timers left, otherwise true is returned
+     */
+    bool begin(void (*funct)(), double microseconds);
+
+    /** This function is used to stop the timer */
+    void end();
+
+    /** This function runs the callback of every timer that is due */
+    void poll() { hostClock.update(); }
+
+    /**
+     * This function is used to get the point in time when the callback is next run
+     * @return is the deadline in microseconds
+     */
+    double getDeadline() { return this->deadline; }
+
+    /** This function is used by the virtual clock to run the callback once it is due */
+    void fire();
+};
+
+#endif
@@ -0,0 +1,632 @@
+/**
+ * This file is responsible for benchmarking the step pipeline. See Benchmark.h for the format of
+ * the results.
+ *
+ * @author Thomas Batchelder
+ * @file Benchmark.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#include "../include/Benchmark.h"
+
+#ifdef RUN_BENCHMARKS
+
+/** Most segments the forward difference candidate advances before it evaluates the profile again */
+#define BENCHMARK_RESEED_SEGMENTS 32
+
+/** Recorder used by every benchmark move */
+StepRecorder stepRecorder;
+/** Jitter of every recorded interrupt, kept so it can be sorted for the percentiles */
+float stepJitter[BENCHMARK_MAX_STEP_EDGES];
+
+/**
+ * This function is used to compare two jitter values for qsort
+ */
+int compareJitter(const void* a, const void* b)
+{
+    float difference = *(const float*)a - *(const float*)b;
+    return (difference > 0) - (difference < 0);
+}
+
+/**
+ * This function is used to get a percentile of a sorted array
+ * @param values is the sorted array
+ * @param count is the number of values in the array
+ * @param percentile is the percentile being found (between 0 and 1)
+ * @return is the value at the percentile
+ */
+double getPercentile(float* values, uint32_t count, double percentile)
+{
+    if (count == 0)
+        return 0;
+    return values[(uint32_t)(percentile * (count - 1) + 0.5)];
+}
+
+/**
+ * This class is used to work out every segment of a movement the same way the event queue does,
+ * without handing the segments to the step engine
+ */
+class ProfileBenchmark : public EventQueue {
+public:
+    /**
+     * This function is used to set the motors the movements are planned for
+     * @param motors is the array of motors
+     */
+    void setMotors(Stepper* motors)
+    {
+        this->motors = motors;
+    }
+
+    /**
+     * This function is used to plan a movement from the zero position of every axis
+     * @param movement is the movement being planned
+     */
+    void plan(MovementEvent* movement)
+    {
+        int32_t initialSteps[DOF] = { 0 };
+        PlannedMovement planned;
+        planned.initVelocity = 0;
+        planned.finalVelocity = 0;
+        planMovement(movement, initialSteps, &planned);
+        this->profile = planned.profile;
+    }
+
+    /**
+     * This function is used to work out the fraction of the movement at the end of every segment
+     * @param forwardDifferences is true if the fractions are advanced with forward differences,
+     * otherwise the profile is evaluated for every segment
+     * @param segments is where the number of segments is stored
+     * @return is the time taken in ticks of the cycle counter
+     */
+    uint32_t evaluate(bool forwardDifferences, uint32_t* segments)
+    {
+        int64_t checksum = 0;
+        restart();
+        *segments = 0;
+        uint32_t start = StepRecorder::cycleCount();
+        while (this->profile.tfin - this->plannedTime > STEP_SEGMENT_MICROSECONDS) {
+            checksum += nextFraction(forwardDifferences);
+            (*segments)++;
+        }
+        uint32_t ticks = StepRecorder::cycleCount() - start;
+        // Keeps the compiler from removing the work being timed
+        this->segmentSink = checksum;
+        return ticks;
+    }
+
+    /**
+     * This function is used to find the largest difference between the steps planned with forward
+     * differences and the steps planned by evaluating the profile
+     * @return is the largest difference of any axis in steps
+     */
+    uint32_t findLargestError()
+    {
+        uint32_t largestError = 0;
+        restart();
+        while (this->profile.tfin - this->plannedTime > STEP_SEGMENT_MICROSECONDS) {
+            int64_t exact = nextFraction(false);
+            this->plannedTime -= STEP_SEGMENT_MICROSECONDS;
+            int64_t forward = nextFraction(true);
+            for (int i = 0; i < DOF; i++) {
+                int64_t exactSteps = ((uint64_t)this->profile.stepChange[i] * exact) >> 32;
+                int64_t forwardSteps = ((uint64_t)this->profile.stepChange[i] * forward) >> 32;
+                largestError = max(largestError, (uint32_t)abs(exactSteps - forwardSteps));
+            }
+        }
+        return largestError;
+    }
+
+protected:
+    /** Result of the last evaluation */
+    volatile int64_t segmentSink = 0;
+
+    /** Fraction of the movement (Q32.32) at the end of the last segment of the forward difference candidate */
+    int64_t fraction = 0;
+    /** First, second and third forward difference of the fraction from one segment to the next (Q32.32) */
+    int64_t fractionDelta[3] = { 0, 0, 0 };
+    /** Last point in time the forward differences can be used up to, the profile is evaluated again after it */
+    uint32_t differencesEnd = 0;
+
+    /** This function is used to start working out the segments from the beginning of the movement */
+    void restart()
+    {
+        this->plannedTime = 0;
+        this->differencesEnd = 0;
+    }
+
+    /**
+     * This function is used to work out the fraction of the movement at the end of the next segment
+     * @param forwardDifferences is true if the fraction is advanced with forward differences
+     * @return is the fraction of the movement (Q32.32)
+     */
+    int64_t nextFraction(bool forwardDifferences)
+    {
+        this->plannedTime += STEP_SEGMENT_MICROSECONDS;
+        if (forwardDifferences)
+            return min(advanceFraction(), MOVEMENT_FRACTION_ONE);
+        return min(evaluateFraction(this->plannedTime), MOVEMENT_FRACTION_ONE);
+    }
+
+    /**
+     * This function is used to evaluate the fraction of the movement at a point in time
+     * @param time is the point in time of the movement in microseconds
+     * @return is the fraction of the movement (Q32.32)
+     */
+    int64_t evaluateFraction(double time)
+    {
+        return (int64_t)(calculateScaler(time) * this->profile.fractionPerDegree);
+    }
+
+    /**
+     * This function is used to get the fraction of the movement at the end of the segment that ends at
+     * plannedTime. Within a phase of the profile the position is a polynomial of time (at most cubic),
+     * so it is advanced from the previous segment with three integer additions. The profile is only
+     * evaluated when a new phase is entered or after BENCHMARK_RESEED_SEGMENTS segments.
+     * @return is the fraction of the movement (Q32.32)
+     */
+    int64_t advanceFraction()
+    {
+        if (this->plannedTime <= this->differencesEnd) {
+            this->fraction += this->fractionDelta[0];
+            this->fractionDelta[0] += this->fractionDelta[1];
+            this->fractionDelta[1] += this->fractionDelta[2];
+            return this->fraction;
+        }
+
+        // The differences are worked out from the next three segments, which have to be in the same phase
+        double time = this->plannedTime, step = STEP_SEGMENT_MICROSECONDS;
+        this->fraction = evaluateFraction(time);
+        this->differencesEnd = this->plannedTime;
+        double phaseEnd = min(getPhaseEnd(time), time + step * BENCHMARK_RESEED_SEGMENTS);
+        if (time + 3 * step <= phaseEnd) {
+            int64_t fractions[4] = { this->fraction, evaluateFraction(time + step), evaluateFraction(time + 2 * step), evaluateFraction(time + 3 * step) };
+            this->fractionDelta[0] = fractions[1] - fractions[0];
+            this->fractionDelta[1] = fractions[2] - 2 * fractions[1] + fractions[0];
+            this->fractionDelta[2] = fractions[3] - 3 * fractions[2] + 3 * fractions[1] - fractions[0];
+            this->differencesEnd = (uint32_t)phaseEnd;
+        }
+        return this->fraction;
+    }
+
+    /**
+     * This function is used to find where the phase of the profile containing a point in time ends
+     * @param time is the point in time of the movement in microseconds
+     * @return is the end of the phase in microseconds
+     */
+    double getPhaseEnd(double time)
+    {
+        double phaseEnds[7] = { this->profile.tap, this->profile.tcsp, this->profile.tfin, this->profile.tfin, this->profile.tfin, this->profile.tfin, this->profile.tfin };
+        if (this->profile.jerk > 0) {
+            // The acceleration and deceleration phases of an S-curve are each made of three phases
+            phaseEnds[0] = this->profile.accelerationJerkTime;
+            phaseEnds[1] = this->profile.tap - this->profile.accelerationJerkTime;
+            phaseEnds[2] = this->profile.tap;
+            phaseEnds[3] = this->profile.tcsp;
+            phaseEnds[4] = this->profile.tcsp + this->profile.decelerationJerkTime;
+            phaseEnds[5] = this->profile.tfin - this->profile.decelerationJerkTime;
+        }
+        for (int i = 0; i < 7; i++) {
+            if (phaseEnds[i] > time)
+                return phaseEnds[i];
+        }
+        return this->profile.tfin;
+    }
+};
+
+/** Queue used to benchmark the evaluation of movement profiles */
+ProfileBenchmark profileBenchmark;
+
+#ifndef ARDUINO
+/** Sequence number of the next frame sent to the arm, nothing else sends frames on a computer */
+uint16_t loadSequence = 0;
+
+/**
+ * This function is used to send a frame to the arm the way Controller.py does during the serial load
+ * benchmark: a movement to the end of the benchmark move, which has nothing left to do once the move
+ * is done, and a queue status request
+ * @param load is the movement sent in the frame
+ * @param hasCredit is true if the event queue has room for the movement, otherwise only the status is requested
+ */
+void sendLoadFrame(SerialLoad* load, bool hasCredit)
+{
+    uint8_t frame[FRAME_SEQUENCE_SIZE + MOVEMENT_RECORD_SIZE + QUEUE_STATUS_RECORD_SIZE + FRAME_CRC_SIZE];
+    uint32_t length = 0;
+    auto pack = [&](const void* value, uint32_t size) {
+        memcpy(frame + length, value, size);
+        length += size;
+    };
+    float movement[DOF + 3] = { 0 };
+    for (int i = 0; i < DOF; i++)
+        movement[i] = load->targetPosition[i];
+    movement[DOF] = load->velocity;
+    movement[DOF + 1] = load->acceleration;
+    uint8_t movementCode = MOVEMENT_EVENT, flags = 0, statusCode = QUEUE_STATUS_REQUEST;
+    pack(&loadSequence, sizeof(loadSequence));
+    if (hasCredit) {
+        pack(&movementCode, sizeof(movementCode));
+        pack(movement, sizeof(movement));
+        pack(&flags, sizeof(flags));
+    }
+    pack(&statusCode, sizeof(statusCode));
+    uint16_t crc = calculateCrc16(frame, length);
+    pack(&crc, sizeof(crc));
+
+    uint8_t encoded[sizeof(frame) + sizeof(frame) / 254 + 2];
+    size_t encodedLength = encodeCobs(frame, length, encoded);
+    encoded[encodedLength++] = FRAME_DELIMITER;
+    Serial.inject(encoded, encodedLength);
+    loadSequence++;
+}
+
+/**
+ * This function is used to hold the virtual clock back to real time while Controller.py sends the
+ * frames through the bridged serial port (HOST_SERIAL_BRIDGE), so the frames arrive as often in
+ * virtual time as they are sent
+ * @param restart is true to line the virtual clock up with real time again
+ */
+void followRealTime(bool restart)
+{
+    static double offset = 0;
+    if (restart)
+        offset = hostClock.realTime() - hostClock.now();
+    while (hostClock.now() + offset > hostClock.realTime()) { }
+}
+#endif
+
+/**
+ * This function is used to run the main loop until every event has been completed
+ * @param controller is the controller of the arm
+ * @param result is where the loop timing is stored (can be NULL)
+ * @param load is the movement sent in the serial load frames, NULL if no frames are sent (only used on a computer,
+ * on the microcontroller the frames are sent by Controller.py)
+ */
+void runUntilIdle(Controller* controller, BenchmarkResult* result, SerialLoad* load)
+{
+    double ticksPerMicrosecond = StepRecorder::ticksPerMicrosecond();
+    double loopTotal = 0, loopMax = 0;
+    uint32_t loops = 0;
+#if defined(HOST_SERIAL_BRIDGE)
+    followRealTime(true);
+#elif !defined(ARDUINO)
+    uint32_t frameTime = micros() - BENCHMARK_SERIAL_FRAME_MICROSECONDS;
+    EventQueue* eventQueue = controller->getEventQueue();
+#endif
+    while (controller->isActive()) {
+#if !defined(ARDUINO) && !defined(HOST_SERIAL_BRIDGE)
+        // The frame is sent before the loop so it is read by the same loop and the move is not finished early
+        if (load != NULL && micros() - frameTime >= BENCHMARK_SERIAL_FRAME_MICROSECONDS) {
+            frameTime = micros();
+            sendLoadFrame(load, eventQueue->getQueueSize() < eventQueue->getQueueCapacity());
+        }
+#endif
+        // The loop is timed with the cycle counter, which keeps moving on a computer while the virtual clock is stopped
+        uint32_t start = StepRecorder::cycleCount();
+        controller->update();
+        double loopTime = (uint32_t)(StepRecorder::cycleCount() - start) / ticksPerMicrosecond;
+#ifndef ARDUINO
+        // The virtual clock does not move while the loop runs, so each loop is given a fixed cost
+        hostClock.advance(BENCHMARK_HOST_LOOP_MICROSECONDS);
+#ifdef HOST_SERIAL_BRIDGE
+        if (load != NULL)
+            followRealTime(false);
+#endif
+#endif
+        loopTotal += loopTime;
+        loopMax = max(loopMax, loopTime);
+        loops++;
+    }
+    if (result != NULL) {
+        result->loopMean = (loops > 0) ? loopTotal / loops : 0;
+        result->loopMax = loopMax;
+    }
+}
+
+/**
+ * This function is used to keep running the main loop once the computer has been asked to stop sending
+ * frames, until the frames still on their way have been answered and their events completed
+ * @param controller is the controller of the arm
+ */
+void waitForQuietLink(Controller* controller)
+{
+    uint32_t quietStart = micros();
+    while (controller->isActive() || micros() - quietStart < BENCHMARK_SERIAL_QUIET_MICROSECONDS) {
+        if (Serial.available() > 0)
+            quietStart = micros();
+        controller->update();
+#ifndef ARDUINO
+        hostClock.advance(BENCHMARK_HOST_LOOP_MICROSECONDS);
+#endif
+#ifdef HOST_SERIAL_BRIDGE
+        followRealTime(false);
+#endif
+    }
+}
+
+/**
+ * This function is used to work out the step rate and jitter from the recorded interrupts
+ * @param result is where the results are stored
+ */
+void analyzeRecording(BenchmarkResult* result)
+{
+    StepEdge* edges = stepRecorder.getEdges();
+    uint32_t edgeCount = stepRecorder.getEdgeCount();
+    double ticksPerMicrosecond = StepRecorder::ticksPerMicrosecond();
+
+    result->edges = edgeCount;
+    result->droppedEdges = stepRecorder.getDroppedEdges();
+    result->steps = 0;
+    result->missedDeadlines = 0;
+
+    for (uint32_t i = 0; i < edgeCount; i++)
+        result->steps += __builtin_popcount(edges[i].axisMask);
+
+    // Every interrupt is compared with the one before it, the first interrupt has nothing to compare with
+    uint32_t jitterCount = 0;
+    for (uint32_t i = 1; i < edgeCount; i++) {
+        double actual = (uint32_t)(edges[i].time - edges[i - 1].time) / ticksPerMicrosecond;
+        double lateness = actual - edges[i].interval;
+        stepJitter[jitterCount++] = fabs(lateness);
+        if (lateness > BENCHMARK_DEADLINE_TOLERANCE_MICROSECONDS)
+            result->missedDeadlines++;
+    }
+
+    // The moves accelerate over the first quarter of their steps and decelerate over the last quarter
+    uint32_t cruiseStart = edgeCount / 4, cruiseEnd = edgeCount * 3 / 4;
+    double cruiseTime = (cruiseEnd > cruiseStart) ? (uint32_t)(edges[cruiseEnd].time - edges[cruiseStart].time) / ticksPerMicrosecond : 0;
+    result->cruiseRate = (cruiseTime > 0) ? (cruiseEnd - cruiseStart) * SECONDS_TO_MICROSECONDS / cruiseTime : 0;
+
+    qsort(stepJitter, jitterCount, sizeof(float), compareJitter);
+    result->jitterP50 = getPercentile(stepJitter, jitterCount, 0.50);
+    result->jitterP90 = getPercentile(stepJitter, jitterCount, 0.90);
+    result->jitterP99 = getPercentile(stepJitter, jitterCount, 0.99);
+    result->jitterMax = (jitterCount > 0) ? stepJitter[jitterCount - 1] : 0;
+}
+
+/**
+ * This function is used to move a set of axes forward and back, recording the forward move.
+ * Every axis takes the same number of steps so each of them runs at the step rate being tested.
+ * @param controller is the controller of the arm
+ * @param axisMask is the mask of the axes being moved
+ * @param stepRate is the step rate each axis should cruise at in Hz
+ * @param serialLoad is true if frames should be sent to the serial port during the move
+ * @param result is where the results are stored
+ */
+void benchmarkMove(Controller* controller, uint8_t axisMask, double stepRate, bool serialLoad, BenchmarkResult* result)
+{
+    Stepper* motors = controller->getSteppers();
+    double targetPosition[DOF];
+    double largestDegreesPerStep = 0;
+    for (int i = 0; i < DOF; i++) {
+        targetPosition[i] = motors[i].getCurrentPositionDegrees();
+        if (axisMask & (1 << i)) {
+            targetPosition[i] += BENCHMARK_MOVE_STEPS * motors[i].getDegreeChangePerStep();
+            largestDegreesPerStep = max(largestDegreesPerStep, motors[i].getDegreeChangePerStep());
+        }
+    }
+    // The move cruises for at least half of its steps
+    double velocity = stepRate * largestDegreesPerStep / SECONDS_TO_MICROSECONDS;
+    double acceleration = sq(velocity) / (2 * (BENCHMARK_MOVE_STEPS / 4) * largestDegreesPerStep);
+
+#ifndef ARDUINO
+    Serial.setEcho(false);
+#endif
+    SerialLoad load;
+    if (serialLoad) {
+        for (int i = 0; i < DOF; i++)
+            load.targetPosition[i] = targetPosition[i];
+        load.velocity = velocity;
+        load.acceleration = acceleration;
+        // Controller.py starts sending frames when it reads this line
+        Serial.print("{\"benchmark\":\"serial_load_start\",\"target_deg\":[");
+        for (int i = 0; i < DOF; i++) {
+            Serial.print(targetPosition[i], 6);
+            Serial.print((i < DOF - 1) ? "," : "],\"velocity\":");
+        }
+        Serial.print(velocity, 12);
+        Serial.print(",\"acceleration\":");
+        Serial.print(acceleration, 18);
+        Serial.println("}");
+    }
+
+    stepRecorder.start();
+    controller->traverseStraightLine(targetPosition, velocity, acceleration, false, false);
+    runUntilIdle(controller, result, serialLoad ? &load : NULL);
+    stepRecorder.stop();
+    if (serialLoad) {
+        Serial.println("{\"benchmark\":\"serial_load_stop\"}");
+        waitForQuietLink(controller);
+    }
+
+    for (int i = 0; i < DOF; i++) {
+        if (axisMask & (1 << i))
+            targetPosition[i] -= BENCHMARK_MOVE_STEPS * motors[i].getDegreeChangePerStep();
+    }
+    controller->traverseStraightLine(targetPosition, velocity, acceleration, false, false);
+    runUntilIdle(controller, NULL, NULL);
+
+#ifndef ARDUINO
+    Serial.takeOutput();
+    Serial.setEcho(true);
+#endif
+    analyzeRecording(result);
+}
+
+/**
+ * This function is used to print the result of a benchmark move as a line of JSON
+ * @param name is the name of the benchmark
+ * @param axisMask is the mask of the axes that were moved
+ * @param stepRate is the step rate that was tested in Hz
+ * @param result is the result of the move
+ */
+void printResult(const char* name, uint8_t axisMask, double stepRate, BenchmarkResult* result)
+{
+    Serial.print("{\"benchmark\":\"");
+    Serial.print(name);
+    Serial.print("\",\"axis_mask\":");
+    Serial.print(axisMask);
+    Serial.print(",\"step_rate_hz\":");
+    Serial.print(stepRate, 0);
+    Serial.print(",\"edges\":");
+    Serial.print(result->edges);
+    Serial.print(",\"steps\":");
+    Serial.print(result->steps);
+    Serial.print(",\"dropped_edges\":");
+    Serial.print(result->droppedEdges);
+    Serial.print(",\"cruise_rate_hz\":");
+    Serial.print(result->cruiseRate, 1);
+    Serial.print(",\"jitter_us\":{\"p50\":");
+    Serial.print(result->jitterP50, 3);
+    Serial.print(",\"p90\":");
+    Serial.print(result->jitterP90, 3);
+    Serial.print(",\"p99\":");
+    Serial.print(result->jitterP99, 3);
+    Serial.print(",\"max\":");
+    Serial.print(result->jitterMax, 3);
+    Serial.print("},\"missed_deadlines\":");
+    Serial.print(result->missedDeadlines);
+    Serial.print(",\"loop_us\":{\"mean\":");
+    Serial.print(result->loopMean, 3);
+    Serial.print(",\"max\":");
+    Serial.print(result->loopMax, 3);
+    Serial.println("}}");
+}
+
+/**
+ * This function is used to time working out the segments of a movement with and without forward
+ * differences and print the result as a line of JSON
+ * @param name is the name of the profile
+ * @param movement is the movement being evaluated (targetSteps is measured from the zero position)
+ */
+void benchmarkProfileEvaluation(const char* name, MovementEvent* movement)
+{
+    uint32_t segments;
+    profileBenchmark.plan(movement);
+    double ticksPerMicrosecond = StepRecorder::ticksPerMicrosecond();
+    uint32_t exactTicks = profileBenchmark.evaluate(false, &segments);
+    uint32_t forwardTicks = profileBenchmark.evaluate(true, &segments);
+    uint32_t largestError = profileBenchmark.findLargestError();
+
+    Serial.print("{\"benchmark\":\"profile_evaluation\",\"profile\":\"");
+    Serial.print(name);
+    Serial.print("\",\"segments\":");
+    Serial.print(segments);
+    Serial.print(",\"ticks_per_segment\":{\"evaluated\":");
+    Serial.print((segments > 0) ? (double)exactTicks / segments : 0, 1);
+    Serial.print(",\"forward_differences\":");
+    Serial.print((segments > 0) ? (double)forwardTicks / segments : 0, 1);
+    Serial.print("},\"ns_per_segment\":{\"evaluated\":");
+    Serial.print((segments > 0) ? exactTicks * 1000.0 / ticksPerMicrosecond / segments : 0, 1);
+    Serial.print(",\"forward_differences\":");
+    Serial.print((segments > 0) ? forwardTicks * 1000.0 / ticksPerMicrosecond / segments : 0, 1);
+    Serial.print("},\"max_error_steps\":");
+    Serial.print(largestError);
+    Serial.println("}");
+}
+
+/**
+ * This function is used to benchmark the evaluation of a trapezoid and an S-curve movement
+ * @param controller is the controller of the arm
+ */
+void benchmarkProfiles(Controller* controller)
+{
+    Stepper* motors = controller->getSteppers();
+    profileBenchmark.setMotors(motors);
+    MovementEvent movement;
+    // Each axis moves 180 degrees at 100 degrees per second
+    for (int i = 0; i < DOF; i++)
+        movement.targetSteps[i] = (int32_t)(180.0 / motors[i].getDegreeChangePerStep());
+    movement.velocity = 1e-4;
+    movement.acceleration = 1e-10;
+    movement.jerk = 0;
+    benchmarkProfileEvaluation("trapezoid", &movement);
+    movement.jerk = 5e-16;
+    benchmarkProfileEvaluation("s_curve", &movement);
+}
+
+/**
+ * This function is used to test every step rate for a set of axes
+ * @param controller is the controller of the arm
+ * @param name is the name of the benchmark
+ * @param axisMask is the mask of the axes being moved
+ * @param serialLoad is true if frames should be sent to the serial port during the moves
+ * @return is the highest cruise rate reached without a missed deadline in Hz
+ */
+double benchmarkStepRates(Controller* controller, const char* name, uint8_t axisMask, bool serialLoad)
+{
+    double stepRates[] = BENCHMARK_STEP_RATES;
+    double maxSustainedRate = 0;
+    for (size_t i = 0; i < sizeof(stepRates) / sizeof(stepRates[0]); i++) {
+        BenchmarkResult result;
+        benchmarkMove(controller, axisMask, stepRates[i], serialLoad, &result);
+        printResult(name, axisMask, stepRates[i], &result);
+        if (result.missedDeadlines == 0 && result.droppedEdges == 0)
+            maxSustainedRate = max(maxSustainedRate, result.cruiseRate);
+    }
+    return maxSustainedRate;
+}
+
+void runBenchmarks(Controller* controller)
+{
+    Stepper* motors = controller->getSteppers();
+    bool crashDetection[DOF];
+    double maxVelocity[DOF], maxAcceleration[DOF];
+    for (int i = 0; i < DOF; i++) {
+        crashDetection[i] = motors[i].isCrashDetectionEnabled();
+        motors[i].setCrashDetection(false);
+        // The step rates tested go past the motion limits of the axes
+        maxVelocity[i] = motors[i].getMaxVelocity();
+        maxAcceleration[i] = motors[i].getMaxAcceleration();
+        motors[i].setMotionLimits(0, 0);
+    }
+    controller->getEventQueue()->clearPlanCache();
+
+#ifdef ARDUINO
+    Serial.print("{\"benchmark\":\"info\",\"platform\":\"teensy41\",\"timestamp_source\":\"cycle_counter\"");
+#else
+    // Every timer runs exactly when it is due, so the results on a computer are the same on every run
+    hostClock.setManual(true);
+    Serial.print("{\"benchmark\":\"info\",\"platform\":\"native\",\"timestamp_source\":\"virtual_clock\"");
+#endif
+    Serial.print(",\"ticks_per_us\":");
+    Serial.print(StepRecorder::ticksPerMicrosecond(), 1);
+    Serial.print(",\"move_steps\":");
+    Serial.print(BENCHMARK_MOVE_STEPS);
+    Serial.print(",\"deadline_tolerance_us\":");
+    Serial.print(BENCHMARK_DEADLINE_TOLERANCE_MICROSECONDS);
+    Serial.println("}");
+
+    benchmarkProfiles(controller);
+
+    double maxSustainedRate[DOF_ACTIVE];
+    for (int i = 0; i < DOF_ACTIVE; i++)
+        maxSustainedRate[i] = benchmarkStepRates(controller, "single_axis", 1 << i, false);
+    uint8_t allAxes = (1 << DOF_ACTIVE) - 1;
+    double allAxesRate = benchmarkStepRates(controller, "all_axes", allAxes, false);
+    // On the microcontroller runBenchmarks() of Controller.py sends the frames during this benchmark
+    double serialLoadRate = benchmarkStepRates(controller, "serial_load", allAxes, true);
+
+    Serial.print("{\"benchmark\":\"summary\",\"max_sustained_rate_hz\":{");
+    for (int i = 0; i < DOF_ACTIVE; i++) {
+        Serial.print("\"axis_");
+        Serial.print(i + 1);
+        Serial.print("\":");
+        Serial.print(maxSustainedRate[i], 1);
+        Serial.print(",");
+    }
+    Serial.print("\"all_axes\":");
+    Serial.print(allAxesRate, 1);
+    Serial.print(",\"serial_load\":");
+    Serial.print(serialLoadRate, 1);
+    Serial.println("}}");
+
+#ifndef ARDUINO
+    hostClock.setManual(false);
+#endif
+    for (int i = 0; i < DOF; i++) {
+        motors[i].setCrashDetection(crashDetection[i]);
+        motors[i].setMotionLimits(maxVelocity[i], maxAcceleration[i]);
+    }
+    controller->getEventQueue()->clearPlanCache();
+}
+
+#endif
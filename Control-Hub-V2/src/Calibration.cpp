@@ -22,7 +22,7 @@ void singleAxisMovement(Controller* controller, uint8_t axis, double targetPosit
         calibrationMovement[i] = controller->getSteppers()[i].getCurrentPositionDegrees();
     }
     calibrationMovement[axis] = targetPosition;
-    controller->traverseStraightLine(calibrationMovement, HOMING_VELOCITY * 5, HOMING_ACCELERATION * 4, 0, 0, false, true);
+    controller->traverseStraightLine(calibrationMovement, HOMING_VELOCITY * 5, HOMING_ACCELERATION * 4, false, true);
 }
 
 bool home(Controller* controller)
@@ -34,8 +34,9 @@ bool home(Controller* controller)
     controller->getEventQueue()->addHomingEvent(HOMING_VELOCITY * 3 / 4, HOMING_ACCELERATION);
     while (controller->getEventQueue()->getQueueSize() != 0) {
         controller->update();
+        uint8_t limitMask = controller->getLimitSwitches()->getLimitMask();
         for (int i = 0; i < DOF_ACTIVE; i++) {
-            if (!axisHomed[i] && controller->getSteppers()[i].readLimitSwitch()) {
+            if (!axisHomed[i] && (limitMask & (1 << i))) {
                 Serial.print("     --> Axis [ ");
                 Serial.print(i + 1);
                 Serial.println(" ] Homed!");
@@ -67,7 +68,7 @@ bool home(Controller* controller)
     }
     Serial.println("  --> Moving off of Limit Switches");
     double homingPosition[DOF] = { 10, 10, 10, 10, 10, 10 };
-    controller->traverseStraightLine(homingPosition, HOMING_VELOCITY, HOMING_ACCELERATION, 0, 0, false, true);
+    controller->traverseStraightLine(homingPosition, HOMING_VELOCITY, HOMING_ACCELERATION, false, true);
     while (controller->getEventQueue()->getQueueSize() != 0) {
         controller->update();
     }
@@ -77,8 +78,9 @@ bool home(Controller* controller)
     controller->getEventQueue()->addHomingEvent(HOMING_VELOCITY / 5, HOMING_ACCELERATION / 5);
     while (controller->getEventQueue()->getQueueSize() != 0) {
         controller->update();
+        uint8_t limitMask = controller->getLimitSwitches()->getLimitMask();
         for (int i = 0; i < DOF_ACTIVE; i++) {
-            if (!axisHomed2[i] && controller->getSteppers()[i].readLimitSwitch()) {
+            if (!axisHomed2[i] && (limitMask & (1 << i))) {
                 Serial.print("     --> Axis [ ");
                 Serial.print(i + 1);
                 Serial.println(" ] Homed!");
@@ -105,7 +107,7 @@ bool home(Controller* controller)
         controller->getSteppers()[i].setCurrentPosition(0);
         controller->getSteppers()[i].setStatus(false);
     }
-    controller->traverseStraightLine(homingPosition3, HOMING_VELOCITY / 2, HOMING_ACCELERATION / 2, 0, 0, false, true);
+    controller->traverseStraightLine(homingPosition3, HOMING_VELOCITY / 2, HOMING_ACCELERATION / 2, false, true);
     for (int i = 0; i < DOF_ACTIVE; i++) {
         controller->getSteppers()[i].resetEncoderPosition();
         controller->getSteppers()[i].setCurrentPosition(0);
@@ -171,12 +173,15 @@ bool encoderCalibration(Controller* controller, uint8_t axis, int iterations)
                 Serial.print("Iteration [ ");
                 Serial.print(j + 1);
                 Serial.println(" ]:");
-                int32_t delta[2] = { controller->getSteppers()[i].readEncoderPosition() };
+                EncoderSnapshot snapshot;
+                controller->snapshotEncoders(&snapshot);
+                int32_t delta[2] = { snapshot.steps[i] };
                 Serial.println(controller->getSteppers()[i].toString());
                 singleAxisMovement(controller, i, axisMovements2[i]);
                 Serial.println(controller->getSteppers()[i].toString());
                 singleAxisMovement(controller, i, 0);
-                delta[1] = controller->getSteppers()[i].readEncoderPosition();
+                controller->snapshotEncoders(&snapshot);
+                delta[1] = snapshot.steps[i];
                 Serial.print("Calculated Drift: [ ");
                 Serial.print(delta[1] - delta[0]);
                 Serial.println(" ]\n");
@@ -234,7 +239,7 @@ bool performFullCalibration(Controller* controller)
     Serial.println();
 
     double homingPosition2[DOF] = { 190, 45, 140, 167, 75, 170 };
-    controller->traverseStraightLine(homingPosition2, HOMING_VELOCITY * 10, HOMING_ACCELERATION * 7.5, 0, 0, false, true);
+    controller->traverseStraightLine(homingPosition2, HOMING_VELOCITY * 10, HOMING_ACCELERATION * 7.5, false, true);
     Serial.println("\n ==================================");
     Serial.println(" === Completed Full Calibration ===");
     Serial.println(" ==================================\n");
@@ -8,40 +8,287 @@
 
 #include "../include/Communication.h"
 
-Communication::Communication(EventQueue* eventQueue)
+Communication::Communication(EventQueue* eventQueue, Telemetry* telemetry)
 {
-    for (int i = 0; i < DOF; i++) {
-        this->data[i] = 0;
-    }
-    this->counter = 0;
-    this->state = INIT_STATE;
+    this->receivedFrames = 0;
+    this->frameOverflow = false;
+    this->frameErrors = 0;
+    this->expectedSequence = 0;
+    this->nackSent = false;
     this->eventQueue = eventQueue;
+    this->telemetry = telemetry;
+    this->advertisedCredits = getCredits();
 }
 
 void Communication::update()
 {
-    double input;
-    if (Serial.available()) {
-        Serial.readBytes((char*)&input, sizeof(input));
-        Serial.println(String(input, 12));
-
-        if (this->state == INIT_STATE) {
-            if ((int)input == MOVEMENT_EVENT) { 
-                Serial.println("Starting Event Transmission");
-                this->state = MOVEMENT_INPUT;
-            }
-        } else if (this->state == MOVEMENT_INPUT) {
-            if ((int)input != END_TRANSMISSION) {
-                Serial.print("Adding to data [ ");
-                Serial.print(this->counter);
-                Serial.println(" ]");
-                this->data[this->counter++] = input;
-            } else {
-                Serial.println("Adding Movement Event");
-                eventQueue->addMovementEvent(data);
-                this->state = INIT_STATE;
-                this->counter = 0;
-            }
+    // Only the bytes already received are read so the main loop is never held up by the serial port
+    while (Serial.available() > 0 && !this->received.isFull()) {
+        uint8_t input = Serial.read();
+        this->received.push(input);
+        if (input == FRAME_DELIMITER)
+            this->receivedFrames++;
+    }
+    if (this->received.isFull() && this->receivedFrames == 0) {
+        // The frame can never fit in the ring, so it is dropped up to its delimiter
+        while (!this->received.isEmpty())
+            this->received.pop();
+        this->frameOverflow = true;
+    }
+    while (this->receivedFrames > 0) {
+        processFrame();
+    }
+
+    uint32_t credits = getCredits();
+    if (credits >= this->advertisedCredits + COMMUNICATION_CREDIT_UPDATE) {
+        this->advertisedCredits = credits;
+        uint16_t values[] = { this->expectedSequence, (uint16_t)credits };
+        sendReply(FRAME_CREDIT, values, 2);
+    }
+}
+
+void Communication::processFrame()
+{
+    FrameState state = {};
+    state.crc = FRAME_CRC_INITIAL;
+    state.isValid = !this->frameOverflow;
+    CobsDecoder decoder;
+    resetCobs(&decoder);
+    uint8_t* input;
+    while ((input = this->received.front()) != NULL) {
+        uint8_t value = *input;
+        this->received.pop();
+        if (value == FRAME_DELIMITER)
+            break;
+        uint8_t decoded;
+        if (state.isValid && decodeCobs(&decoder, value, &decoded))
+            decodeByte(decoded, &state);
+    }
+    this->receivedFrames--;
+    this->frameOverflow = false;
+
+    // The records are all checked before any event is added, so a frame is either used whole or not at all
+    uint16_t crc = state.lastBytes[0] | (state.lastBytes[1] << 8);
+    if (!state.isValid || !isCobsComplete(&decoder) || state.length < FRAME_SEQUENCE_SIZE + FRAME_CRC_SIZE || state.recordIndex != 0 || crc != state.crc) {
+        sendNack(true);
+        return;
+    }
+    int16_t sequenceDifference = (int16_t)(state.sequence - this->expectedSequence);
+    if (sequenceDifference < 0) {
+        // The computer did not get the reply to this frame, it is answered again without being used
+        sendAck(state.sequence, 0, 0, getCredits());
+        return;
+    }
+    if (sequenceDifference > 0) {
+        if (!this->nackSent)
+            sendNack(false);
+        return;
+    }
+    if (state.isOverCredit) {
+        sendNack(false);
+        return;
+    }
+
+    if (state.reservedSetpoints > 0)
+        this->eventQueue->commitSetpoints(state.reservedSetpoints);
+    if (state.reservedEvents > 0)
+        this->eventQueue->commitEvent(state.reservedEvents);
+    this->expectedSequence++;
+    this->nackSent = false;
+    this->advertisedCredits = getCredits();
+    sendAck(state.sequence, state.accepted, state.rejected, this->advertisedCredits);
+    if (state.telemetryRateRequested)
+        this->telemetry->setRate(state.telemetryRate);
+    if (state.statusRequested)
+        reportQueueStatus();
+}
+
+void Communication::decodeByte(uint8_t value, FrameState* state)
+{
+    // The last two bytes of the frame are its CRC, so a byte is only used once two more have been decoded
+    state->length++;
+    if (state->length <= FRAME_CRC_SIZE) {
+        state->lastBytes[state->length - 1] = value;
+        return;
+    }
+    uint8_t frameByte = state->lastBytes[0];
+    state->lastBytes[0] = state->lastBytes[1];
+    state->lastBytes[1] = value;
+    state->crc = updateCrc16(state->crc, frameByte);
+
+    uint32_t index = state->length - FRAME_CRC_SIZE - 1;
+    if (index < FRAME_SEQUENCE_SIZE) {
+        state->sequence |= frameByte << (8 * index);
+        state->isExpected = index == FRAME_SEQUENCE_SIZE - 1 && state->sequence == this->expectedSequence;
+        return;
+    }
+    decodeRecordByte(frameByte, state);
+}
+
+void Communication::decodeRecordByte(uint8_t value, FrameState* state)
+{
+    if (state->recordIndex == 0) {
+        state->recordCode = value;
+        state->recordSize = getRecordSize(value);
+        state->slot = NULL;
+        state->setpoint = NULL;
+        state->values = NULL;
+        if (state->recordSize == 0) {
+            state->isValid = false;
+            return;
+        }
+        if (value == STREAM_SETPOINT) {
+            // A setpoint that does not fit is rejected rather than sent again, it would be stale by the time it arrived
+            if (state->isExpected)
+                state->setpoint = this->eventQueue->reserveSetpoint(state->reservedSetpoints);
+            state->values = (uint8_t*)state->setpoint;
+        } else if (value == TELEMETRY_RATE_REQUEST) {
+            state->values = (uint8_t*)&state->telemetryRate;
+        } else if (value != QUEUE_STATUS_REQUEST && state->isExpected && !state->isOverCredit) {
+            state->slot = this->eventQueue->reserveEvent(state->reservedEvents);
+            if (state->slot != NULL)
+                state->values = state->eventValues;
+            state->isOverCredit = state->slot == NULL;
         }
+    } else if (state->values != NULL) {
+        // Setpoints are decoded straight into their slot, events are filled in once the whole record is decoded
+        state->values[state->recordIndex - 1] = value;
     }
+    state->recordIndex++;
+    if (state->recordIndex < state->recordSize)
+        return;
+
+    state->recordIndex = 0;
+    if (state->recordCode == QUEUE_STATUS_REQUEST) {
+        state->statusRequested = true;
+    } else if (state->recordCode == TELEMETRY_RATE_REQUEST) {
+        state->telemetryRateRequested = true;
+    } else if (state->recordCode == STREAM_SETPOINT) {
+        if (state->setpoint != NULL && this->eventQueue->checkSetpoint(state->setpoint)) {
+            state->reservedSetpoints++;
+            state->accepted++;
+        } else {
+            state->rejected++;
+        }
+    } else if (state->slot != NULL) {
+        if (decodeEvent(state->recordCode, state->eventValues, state->slot)) {
+            state->reservedEvents++;
+            state->accepted++;
+        } else {
+            state->rejected++;
+        }
+    }
+}
+
+bool Communication::decodeEvent(uint8_t code, uint8_t* values, EventNode* slot)
+{
+    switch (code) {
+    case MOVEMENT_EVENT: {
+        float movement[DOF + 3];
+        memcpy(movement, values, sizeof(movement));
+        double finalPosition[DOF];
+        for (int i = 0; i < DOF; i++) {
+            finalPosition[i] = movement[i];
+        }
+        bool useEncoderPosition = values[sizeof(movement)] & MOVEMENT_USE_ENCODER_POSITION;
+        return this->eventQueue->setMovementEvent(slot, MOVEMENT_EVENT, finalPosition, movement[DOF], movement[DOF + 1], useEncoderPosition, movement[DOF + 2]);
+    }
+    case SLEEP_EVENT: {
+        uint32_t sleepTime;
+        memcpy(&sleepTime, values, sizeof(sleepTime));
+        this->eventQueue->setSleepEvent(slot, sleepTime);
+        return true;
+    }
+    case HOMING_EVENT: {
+        float homing[2];
+        memcpy(homing, values, sizeof(homing));
+        return this->eventQueue->setHomingEvent(slot, homing[0], homing[1]);
+    }
+    case STREAM_EVENT: {
+        uint32_t playbackDelay;
+        memcpy(&playbackDelay, values, sizeof(playbackDelay));
+        return this->eventQueue->setStreamEvent(slot, playbackDelay, values[sizeof(playbackDelay)]);
+    }
+    }
+    return false;
+}
+
+uint32_t Communication::getRecordSize(uint8_t code)
+{
+    switch (code) {
+    case MOVEMENT_EVENT:
+        return MOVEMENT_RECORD_SIZE;
+    case SLEEP_EVENT:
+        return SLEEP_RECORD_SIZE;
+    case HOMING_EVENT:
+        return HOMING_RECORD_SIZE;
+    case QUEUE_STATUS_REQUEST:
+        return QUEUE_STATUS_RECORD_SIZE;
+    case STREAM_EVENT:
+        return STREAM_RECORD_SIZE;
+    case STREAM_SETPOINT:
+        return SETPOINT_RECORD_SIZE;
+    case TELEMETRY_RATE_REQUEST:
+        return TELEMETRY_RATE_RECORD_SIZE;
+    }
+    return 0;
+}
+
+uint32_t Communication::getCredits()
+{
+    return this->eventQueue->getQueueCapacity() - this->eventQueue->getQueueSize();
+}
+
+void Communication::sendAck(uint16_t sequence, uint16_t accepted, uint16_t rejected, uint16_t credits)
+{
+    uint16_t values[] = { sequence, accepted, rejected, credits };
+    sendReply(FRAME_ACK, values, 4);
+}
+
+void Communication::sendNack(bool isFrameError)
+{
+    if (isFrameError)
+        this->frameErrors++;
+    this->nackSent = true;
+    this->advertisedCredits = getCredits();
+    uint16_t values[] = { this->expectedSequence, (uint16_t)this->advertisedCredits };
+    sendReply(FRAME_NACK, values, 2);
+}
+
+void Communication::sendReply(uint8_t type, const uint16_t* values, uint32_t count)
+{
+    uint8_t frame[ACK_REPLY_SIZE + FRAME_CRC_SIZE];
+    frame[0] = type;
+    memcpy(frame + 1, values, count * sizeof(uint16_t));
+    uint8_t encoded[FRAME_ENCODED_SIZE(ACK_REPLY_SIZE)];
+    Serial.write(encoded, encodeFrame(frame, 1 + count * sizeof(uint16_t), encoded));
+}
+
+void Communication::reportQueueStatus()
+{
+    Serial.print("Queue Status: ");
+    Serial.print(this->eventQueue->getQueueSize());
+    Serial.print(" ");
+    Serial.print(this->eventQueue->getQueueCapacity());
+    Serial.print(" ");
+    Serial.print(this->eventQueue->getHighWaterMark());
+    Serial.print(" ");
+    Serial.print(this->eventQueue->getRejectedEvents());
+    Serial.print(" ");
+    Serial.print((uint32_t)(this->eventQueue->getQueueCapacity() * sizeof(EventNode)));
+    Serial.print(" ");
+    Serial.print(this->eventQueue->getPlanCacheHits());
+    Serial.print(" ");
+    Serial.print(this->eventQueue->getPlanCacheMisses());
+    Serial.print(" ");
+    Serial.print(this->frameErrors);
+    Serial.print(" ");
+    Serial.print(this->eventQueue->getBufferedSetpoints());
+    Serial.print(" ");
+    Serial.println(this->eventQueue->getStreamUnderruns());
+}
+
+uint32_t Communication::getFrameErrors()
+{
+    return this->frameErrors;
 }
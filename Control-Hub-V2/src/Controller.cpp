@@ -10,19 +10,8 @@
 
 Controller::Controller()
 {
-    // Getting pins for controlling the stepper motors
-    uint8_t stepPins[DOF] = STEP_PINS;
-    uint8_t dirPins[DOF] = DIR_PINS;
     uint8_t limPins[DOF] = LIMIT_SWITCH_PINS;
 
-    // Getting motor information
-    int32_t mircosteping[DOF] = MICROSTEPING;
-    int32_t encoderThreshold[DOF] = ENCODER_THRESHOLD;
-    int32_t maxPosition[DOF] = MAX_POSITION;
-    double gearReduction[DOF] = GEAR_REDUCTION;
-    bool invertDir[DOF] = INVERT_DIR;
-    bool crashDetection[DOF] = CRASH_DETECTION;
-
     this->encoders[0] = &motorEncoder1;
     this->encoders[1] = &motorEncoder2;
     this->encoders[2] = &motorEncoder3;
@@ -30,41 +19,41 @@ Controller::Controller()
     this->encoders[4] = &motorEncoder5;
     this->encoders[5] = &motorEncoder6;
 
-    for (size_t i = 0; i < DOF; i++) {
-        this->motors[i] = Stepper(
-            stepPins[i],
-            dirPins[i],
-            limPins[i],
-            this->encoders[i],
-            mircosteping[i],
-            gearReduction[i],
-            maxPosition[i],
-            invertDir[i],
-            encoderThreshold[i],
-            i, 
-            crashDetection[i]);
-    }
+    this->limitSwitches = LimitSwitchSampler(limPins);
+
+    // The motors are built from the compile time description of each axis in Configuration.h
+    forEachAxis<DOF>([&](auto axis) {
+        typedef AxisConfig<decltype(axis)::value> Config;
+        this->motors[Config::axis] = Stepper::fromConfig<Config::axis>(this->encoders[Config::axis]);
+        this->motors[Config::axis].setLimitSwitchSampler(&this->limitSwitches);
+#ifndef ARDUINO
+        // On a computer the encoders count the step pulses of their motor (clockwise is counted up)
+        this->encoders[Config::axis]->followStepper(Config::stepPin, Config::dirPin, Config::invertDir, (int32_t)ENCODER_CPR, Config::microsteping);
+#endif
+    });
+    this->limitSwitches.begin();
 
     this->eventQueue = EventQueue(this->motors);
-    this->communication = Communication(&this->eventQueue);
+    this->communication = Communication(&this->eventQueue, &this->telemetry);
+    this->telemetry = Telemetry(this->motors, &this->eventQueue, &this->communication);
 }
 
 void Controller::update()
 {
+    limitSwitches.poll();
     eventQueue.update();
     communication.update();
+    telemetry.update();
 }
 
 void Controller::traverseStraightLine(
     double* targetPosition,
     double velocity,
     double acceleration,
-    double initVelocity,
-    double finalVelocity,
     bool useEncoderPosition,
     bool blocking)
 {
-    this->eventQueue.addMovementEvent(targetPosition, velocity, acceleration, initVelocity, finalVelocity, useEncoderPosition);
+    this->eventQueue.addMovementEvent(targetPosition, velocity, acceleration, useEncoderPosition);
     if (blocking) {
         while (this->eventQueue.getQueueSize() > 0) {
             this->update();
@@ -75,10 +64,17 @@ void Controller::traverseStraightLine(
 void Controller::savePosition()
 {
     double currentPosition[DOF];
+    EncoderSnapshot snapshot;
+    snapshotEncoders(&snapshot);
     for (int i = 0; i < DOF; i++) {
-        currentPosition[i] = this->motors[i].readEncoderPosition() * this->motors[i].getDegreeChangePerStep();
+        currentPosition[i] = snapshot.steps[i] * this->motors[i].getDegreeChangePerStep();
     }
-    traverseStraightLine(currentPosition, HOMING_VELOCITY * 3, HOMING_ACCELERATION * 3, 0, 0, false, false);
+    traverseStraightLine(currentPosition, HOMING_VELOCITY * 3, HOMING_ACCELERATION * 3, false, false);
+}
+
+void Controller::snapshotEncoders(EncoderSnapshot* snapshot)
+{
+    readEncoderSnapshot(this->motors, snapshot);
 }
 
 Stepper* Controller::getSteppers()
@@ -91,11 +87,21 @@ Encoder* Controller::getEncoders()
     return this->encoders[0];
 }
 
+LimitSwitchSampler* Controller::getLimitSwitches()
+{
+    return &this->limitSwitches;
+}
+
 EventQueue* Controller::getEventQueue()
 {
     return &this->eventQueue;
 }
 
+Communication* Controller::getCommunication()
+{
+    return &this->communication;
+}
+
 bool Controller::isActive()
 {
     return (this->eventQueue.getQueueSize() != 0);
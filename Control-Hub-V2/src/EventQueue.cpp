@@ -16,10 +16,8 @@
 
 EventQueue::EventQueue(Stepper* motors)
 {
-    this->head = NULL;
-    this->tail = NULL;
-    this->queueSize = 0;
     this->motors = motors;
+    this->stepEngine = StepEngine(motors);
 }
 
 bool EventQueue::isArmActive()
@@ -34,8 +32,67 @@ bool EventQueue::isArmMoving()
 
 uint32_t EventQueue::getQueueSize()
 {
-    return this->queueSize;
+    return this->events.size();
 }
+
+uint32_t EventQueue::getQueueCapacity()
+{
+    return this->events.getCapacity();
+}
+
+uint32_t EventQueue::getHighWaterMark()
+{
+    return this->highWaterMark;
+}
+
+uint32_t EventQueue::getRejectedEvents()
+{
+    return this->rejectedEvents;
+}
+
+void EventQueue::resetQueueStatistics()
+{
+    this->highWaterMark = this->events.size();
+    this->rejectedEvents = 0;
+    this->planCache.resetStatistics();
+    this->streamUnderruns = 0;
+}
+
+uint32_t EventQueue::getPlanCacheHits()
+{
+    return this->planCache.getHits();
+}
+
+uint32_t EventQueue::getPlanCacheMisses()
+{
+    return this->planCache.getMisses();
+}
+
+void EventQueue::clearPlanCache()
+{
+    this->planCache.clear();
+}
+
+uint32_t EventQueue::getBufferedSetpoints()
+{
+    return this->setpoints.size();
+}
+
+uint32_t EventQueue::getStreamUnderruns()
+{
+    return this->streamUnderruns;
+}
+
+CrashRecovery* EventQueue::getLastCrashRecovery()
+{
+    return &this->lastRecovery;
+}
+
+bool EventQueue::isRecoveringFromCrash()
+{
+    return this->recoveryState != RECOVERY_NONE;
+}
+
 uint32_t EventQueue::getErrorCodeAndReset()
 {
     uint32_t temp = this->errorCode;
@@ -49,9 +106,13 @@ uint32_t EventQueue::getErrorCodeAndReset()
 
 void EventQueue::update()
 {
-    if (this->head == NULL)
+    this->stepEngine.poll();
+    if (this->events.size() != this->lookAheadSize)
+        planLookAhead();
+    EventNode* event = this->events.front();
+    if (event == NULL)
         return;
-    switch (this->head->eventCode) {
+    switch (event->eventCode) {
     case MOVEMENT_EVENT:
         processMovementEvent();
         break;
@@ -61,58 +122,85 @@ void EventQueue::update()
     case HOMING_EVENT:
         processHomingEvent();
         break;
+    case STREAM_EVENT:
+        processStreamEvent();
+        break;
     }
 }
 
 void EventQueue::eventCompleted()
 {
-    if (this->head != NULL) {
-        EventNode* temp = this->head->nextEvent;
-        free(this->head);
-        this->head = temp;
-        this->queueSize--;
+    if (!this->events.isEmpty()) {
+        this->stepEngine.stop();
+        popEvent();
+    }
+}
+
+void EventQueue::popEvent()
+{
+    if (!this->events.isEmpty()) {
+        this->events.pop();
+        // The look-ahead planner is run again when a movement moves up into the profile table
+        if (this->events.size() < LOOK_AHEAD_PROFILES)
+            this->lookAheadSize--;
         this->isRobotMoving = false;
         this->isRobotActive = false;
     }
 }
 
-void EventQueue::addEvent(EventNode* newEvent)
+bool EventQueue::isChainedMovement(EventNode* event)
 {
-    if (this->head == NULL) {
-        this->head = newEvent;
-        this->tail = this->head;
-    } else {
-        this->tail->nextEvent = newEvent;
-        this->tail = newEvent;
+    return event != NULL && event->eventCode == MOVEMENT_EVENT && !event->useEncoderPosition;
+}
+
+EventNode* EventQueue::reserveEvent(uint32_t index)
+{
+    EventNode* newEvent = this->events.reserve(index);
+    if (newEvent == NULL) {
+        this->errorCode = EVENT_QUEUE_FULL;
+        this->rejectedEvents++;
     }
-    newEvent->nextEvent = NULL;
-    this->queueSize++;
+    return newEvent;
+}
+
+void EventQueue::commitEvent(uint32_t count)
+{
+    this->events.commit(count);
+    this->highWaterMark = max(this->highWaterMark, this->events.size());
 }
 
 // +---------------------------------------------------+ //
 // |               --- Movement Event ---              | //
 // +---------------------------------------------------+ //
 
-bool EventQueue::addMovementEvent(double* data)
+bool EventQueue::addMovementEvent(
+    double* finalPosition,
+    double velocity,
+    double acceleration,
+    bool useEncoderPosition,
+    double jerk)
 {
-    double finalPosition[DOF] = { data[0], data[1], data[2], data[3], data[4], data[5] };
-    double velocity = data[6];
-    double acceleration = data[7];
-    double initVelocity = data[8];
-    double finalVelocity = data[9];
-    bool useEncoderPosition = (bool)((int)data[10]);
-    return addMovementEvent(finalPosition, velocity, acceleration, initVelocity, finalVelocity, useEncoderPosition);
+    EventNode* newEvent = reserveEvent();
+    if (newEvent == NULL || !setMovementEvent(newEvent, MOVEMENT_EVENT, finalPosition, velocity, acceleration, useEncoderPosition, jerk))
+        return false;
+    commitEvent();
+    return true;
 }
 
-bool EventQueue::addMovementEvent(
+bool EventQueue::setMovementEvent(
+    EventNode* event,
+    uint8_t eventCode,
     double* finalPosition,
     double velocity,
     double acceleration,
-    double initVelocity,
-    double finalVelocity,
-    bool useEncoderPosition)
+    bool useEncoderPosition,
+    double jerk)
 {
     // Error Checking
+    if (jerk < 0) {
+        this->errorCode = INVALID_JERK;
+        return false;
+    }
     for (int i = 0; i < DOF; i++) {
         if (this->motors[i].getMaximumPosition() != -1 && (this->motors[i].getMaximumPosition() * this->motors[i].getDegreeChangePerStep() < finalPosition[i] || finalPosition[i] < 0)) {
             this->errorCode = OUTSIDE_OF_MOTOR_BOUNDS;
@@ -134,77 +222,52 @@ bool EventQueue::addMovementEvent(
         Serial.println(String(velocity, 12));
         Serial.print("Acceleration:     \t");
         Serial.println(String(acceleration, 12));
-        Serial.print("Initial Velocity: \t");
-        Serial.println(String(initVelocity, 12));
-        Serial.print("Final Velocity:   \t");
-        Serial.println(String(finalVelocity, 12));
+        Serial.print("Jerk:             \t");
+        Serial.println(String(jerk, 18));
         Serial.print("Use Encoder Position:\t");
         Serial.println(useEncoderPosition);
         Serial.println();
     }
-    // Creating a new EventNode
-    EventNode* newEvent = (EventNode*)malloc(sizeof(EventNode));
-    newEvent->eventCode = MOVEMENT_EVENT;
-    newEvent->timeVariable = micros();
-    newEvent->kinematicInfo[0] = velocity;
-    newEvent->kinematicInfo[1] = acceleration;
-    newEvent->kinematicInfo[2] = initVelocity;
-    newEvent->kinematicInfo[3] = finalVelocity;
-    newEvent->useEncoderPosition = useEncoderPosition;
+    // Filling in the reserved EventNode
+    event->eventCode = eventCode;
+    event->movement.velocity = velocity;
+    event->movement.acceleration = acceleration;
+    event->movement.jerk = jerk;
+    event->useEncoderPosition = useEncoderPosition;
+    event->isPlanned = false;
     for (int i = 0; i < DOF; i++) {
-        newEvent->targetPosition[i] = finalPosition[i];
+        event->movement.targetSteps[i] = lround(finalPosition[i] / this->motors[i].getDegreeChangePerStep());
     }
-    addEvent(newEvent);
     return true;
 }
 
 void EventQueue::processMovementEvent()
 {
     if (!this->isRobotActive) {
+        // The encoder position is only valid once the steps of the previous movement are done
+        if (this->events.front()->useEncoderPosition && !this->stepEngine.isIdle())
+            return;
         this->isRobotActive = true;
         this->isRobotMoving = true;
         calculateMovementEvent();
     }
 
-    uint32_t currentTime = micros();
-    if (currentTime - this->eventStartTime <= this->tfin) {
-        timeDelta = currentTime - this->eventStartTime;
-        //acceleration phase
-        if (timeDelta <= this->tap) {
-            this->scaler = this->initVelocity * this->timeDelta + this->acceleration * this->timeDelta * this->timeDelta / 2.0;
-        }
-        //contant maximum speed phase
-        if (timeDelta > this->tap && timeDelta <= this->tcsp) {
-            this->scaler = this->lap + this->velocity * (timeDelta - this->tap);
-        }
-        //deceleration phase
-        if (timeDelta > tcsp) {
-            this->scaler = this->lcsp + this->velocity * (timeDelta - this->tcsp) - this->acceleration * (timeDelta - this->tcsp) * (timeDelta - this->tcsp) / 2.0;
-        }
-        //trajectory x and y as a function of scalar
-        double updatedTrajectory[6];
-        for (int i = 0; i < DOF; i++) {
-            updatedTrajectory[i] = this->initialPosition[i] + (this->targetPosition[i] - this->initialPosition[i]) / this->largestDegreeChange * this->scaler;
-        }
-        performTrajectory(updatedTrajectory);
-        for (int i = 0; i < DOF_ACTIVE; i++) {
-            if (!this->motors[i].comparePositionToEncoder()) {
-                Serial.println("Crash Detected! Recalculating Movement...");
-                Serial.print("Axis: ");
-                Serial.println(i + 1);
-                Serial.print("Motor Pos:\t");
-                Serial.println(this->motors[i].getCurrentPositionSteps());
-                Serial.print("Encoder Pos:\t");
-                Serial.println(this->motors[i].readEncoderPosition());
-                if (this->head->kinematicInfo[0] / 2 > 0.1e-4)
-                    this->head->kinematicInfo[0] = this->head->kinematicInfo[0] / 2;
-                this->head->useEncoderPosition = true;
-                delay(1000);
-                calculateMovementEvent();
-                break; 
-            }
+    if (this->recoveryState != RECOVERY_NONE) {
+        processCrashRecovery();
+        return;
+    }
+
+    planSegments();
+    EncoderSnapshot snapshot;
+    readEncoderSnapshot(this->motors, &snapshot);
+    for (int i = 0; i < DOF_ACTIVE; i++) {
+        if (!this->motors[i].comparePositionToEncoder(snapshot.steps[i])) {
+            startCrashRecovery(i, &snapshot);
+            return;
         }
-    } else {
+    }
+    // The next movement is started as soon as this one is planned, so the step engine never runs dry between them
+    if (this->plannedTime >= this->profile.tfin && (this->stepEngine.isIdle() || isChainedMovement(this->events.at(1)))) {
         if (this->printEventInfo) {
             Serial.print("Final Trajectory:\t");
             for (int i = 0; i < DOF; i++) {
@@ -213,120 +276,580 @@ void EventQueue::processMovementEvent()
             }
             Serial.println("\n  --- Straight Line Movement: COMPLETE ---");
         }
-        eventCompleted();
+        popEvent();
     }
 }
 
+void EventQueue::startCrashRecovery(int axis, EncoderSnapshot* snapshot)
+{
+    this->recoveryState = RECOVERY_DECELERATING;
+    this->recoveryStateTime = micros();
+    this->recovery.axis = axis + 1;
+    this->recovery.motorSteps = this->motors[axis].getCurrentPositionSteps();
+    this->recovery.encoderSteps = snapshot->steps[axis];
+    this->recovery.detectedTime = this->recoveryStateTime;
+
+    // The arm slows down from the velocity at the end of the segments already handed to the step engine
+    double time = this->plannedTime;
+    double step = min(time, (double)STEP_SEGMENT_MICROSECONDS);
+    this->recoveryVelocity = 0;
+    if (time >= this->profile.tfin) {
+        this->segmentFraction = MOVEMENT_FRACTION_ONE;
+    } else {
+        this->segmentFraction = calculateScaler(time) * this->profile.fractionPerDegree;
+        if (step > 0)
+            this->recoveryVelocity = (calculateScaler(time) - calculateScaler(time - step)) / step;
+    }
+}
+
+void EventQueue::processCrashRecovery()
+{
+    uint32_t now = micros();
+    if (this->recoveryState == RECOVERY_DECELERATING) {
+        while (this->recoveryVelocity > 0 && this->stepEngine.isReady()) {
+            planStoppingSegment();
+        }
+        if (this->recoveryVelocity > 0 || !this->stepEngine.isIdle())
+            return;
+        this->recovery.decelerationTime = now - this->recoveryStateTime;
+        this->recoveryState = RECOVERY_SETTLING;
+        this->recoveryStateTime = now;
+        return;
+    }
+
+    // Settling
+    if (now - this->recoveryStateTime < CRASH_RECOVERY_SETTLE_MICROSECONDS)
+        return;
+    this->recovery.settleTime = now - this->recoveryStateTime;
+    this->recoveryState = RECOVERY_NONE;
+
+    EventNode* event = this->events.front();
+    if (event->movement.velocity / 2 > CRASH_RECOVERY_MIN_VELOCITY)
+        event->movement.velocity = event->movement.velocity / 2;
+    // The motor positions are taken from an encoder snapshot when the movement is started again
+    event->useEncoderPosition = true;
+    getPlannedMovement(event)->initVelocity = 0;
+    event->isPlanned = false;
+    calculateMovementEvent();
+    // The final velocity may have changed, so the movements after this one are planned again
+    this->lookAheadSize = 0;
+
+    this->recovery.velocity = this->profile.velocity;
+    this->recovery.count = this->lastRecovery.count + 1;
+    this->lastRecovery = this->recovery;
+}
+
+void EventQueue::planStoppingSegment()
+{
+    double duration = STEP_SEGMENT_MICROSECONDS;
+    double velocity = max(this->recoveryVelocity - this->profile.acceleration * duration, 0.0);
+    // The last segment ends when the arm stops
+    if (velocity == 0 && this->profile.acceleration > 0)
+        duration = min(duration, this->recoveryVelocity / this->profile.acceleration);
+    this->segmentFraction += (this->recoveryVelocity + velocity) / 2 * duration * this->profile.fractionPerDegree;
+    this->recoveryVelocity = velocity;
+    if (this->segmentFraction >= MOVEMENT_FRACTION_ONE) {
+        this->segmentFraction = MOVEMENT_FRACTION_ONE;
+        this->recoveryVelocity = 0;
+    }
+    performTrajectory((int64_t)this->segmentFraction, (uint32_t)ceil(duration));
+}
+
 void EventQueue::calculateMovementEvent()
 {
+    EventNode* event = this->events.front();
+    EncoderSnapshot snapshot;
+    if (event->useEncoderPosition)
+        readEncoderSnapshot(this->motors, &snapshot);
+    // While the steps of the previous movement are still being performed this movement starts at its target
+    bool continuesMovement = !this->stepEngine.isIdle();
     for (int i = 0; i < DOF; i++) {
-        if (!this->head->useEncoderPosition) {
-            this->initialPosition[i] = motors[i].getCurrentPositionDegrees();
-        } else {
-            this->motors[i].setCurrentPosition(this->motors[i].readEncoderPosition());
-            this->initialPosition[i] = motors[i].getCurrentPositionDegrees();
-        }
-        this->targetPosition[i] = this->head->targetPosition[i];
+        if (event->useEncoderPosition)
+            this->motors[i].setCurrentPosition(snapshot.steps[i]);
+        if (!continuesMovement)
+            this->initialSteps[i] = this->motors[i].getCurrentPositionSteps();
+        else
+            this->initialSteps[i] = this->targetSteps[i];
+        this->targetSteps[i] = event->movement.targetSteps[i];
+        this->plannedSteps[i] = 0;
     }
-    this->velocity = this->head->kinematicInfo[0];
-    this->acceleration = this->head->kinematicInfo[1];
-    this->initVelocity = this->head->kinematicInfo[2];
-    this->finalVelocity = this->head->kinematicInfo[3];
-    if (printEventInfo) {
+    // The profile is normally worked out by the look-ahead planner while the event waits in the queue
+    PlannedMovement* planned = getPlannedMovement(event);
+    if (!isPlannedFrom(event, this->initialSteps)) {
+        planMovement(&event->movement, this->initialSteps, planned);
+        event->isPlanned = true;
+    }
+    this->profile = planned->profile;
+
+    this->eventStartTime = micros();
+    this->plannedTime = 0;
+
+    if (this->printEventInfo) {
         Serial.print("Velocity:\t\t");
-        Serial.println(String(this->velocity, 10));
+        Serial.println(String(this->profile.velocity, 10));
         Serial.print("Acceleration:\t\t");
-        Serial.println(String(this->acceleration, 10));
+        Serial.println(String(this->profile.acceleration, 10));
         Serial.print("Initial Velocity:\t");
-        Serial.println(String(this->initVelocity, 10));
+        Serial.println(String(this->profile.initVelocity, 10));
         Serial.print("Final Velocity:\t\t");
-        Serial.println(String(this->finalVelocity, 10));
+        Serial.println(String(this->profile.finalVelocity, 10));
+        Serial.print("Jerk:\t\t\t");
+        Serial.println(String(this->profile.jerk, 18));
+        Serial.print("Initial Trajectory:\t");
+        for (int i = 0; i < DOF; i++) {
+            Serial.print(String(this->initialSteps[i] * this->motors[i].getDegreeChangePerStep(), 2));
+            Serial.print("\t ");
+        }
+        Serial.println();
+        Serial.print("Total Movement Time:\t");
+        Serial.println(this->profile.tfin);
+        Serial.print("Largest Degree Change:\t");
+        Serial.println(this->profile.largestDegreeChange);
     }
+}
+
+PlannedMovement* EventQueue::getPlannedMovement(EventNode* event)
+{
+    return &this->plannedMovements[this->events.indexOf(event) & (LOOK_AHEAD_PROFILES - 1)];
+}
 
-    this->largestDegreeChange = 0;
+void EventQueue::planMovement(MovementEvent* movement, int32_t* initialSteps, PlannedMovement* planned)
+{
+    MovementProfile* profile = &planned->profile;
+    PlanKey key;
     for (int i = 0; i < DOF; i++) {
-        this->largestDegreeChange = max(this->largestDegreeChange, abs(this->targetPosition[i] - this->initialPosition[i]));
+        key.initialSteps[i] = initialSteps[i];
+        key.targetSteps[i] = movement->targetSteps[i];
     }
+    key.velocity = movement->velocity;
+    key.acceleration = movement->acceleration;
+    key.initVelocity = planned->initVelocity;
+    key.finalVelocity = planned->finalVelocity;
+    key.jerk = movement->jerk;
+    if (this->planCache.lookup(key, profile))
+        return;
 
+    double degreeChange[DOF];
+    profile->directionMask = 0;
+    profile->largestDegreeChange = 0;
     for (int i = 0; i < DOF; i++) {
-        if (this->targetPosition[i] - initialPosition[i] < 0.0) {
-            this->motors[i].setDirection(COUNTERCLOCKWISE);
-        } else {
-            this->motors[i].setDirection(CLOCKWISE);
+        if (movement->targetSteps[i] < initialSteps[i])
+            profile->directionMask |= 1 << i;
+        profile->stepChange[i] = abs(movement->targetSteps[i] - initialSteps[i]);
+        degreeChange[i] = profile->stepChange[i] * this->motors[i].getDegreeChangePerStep();
+        profile->largestDegreeChange = max(profile->largestDegreeChange, degreeChange[i]);
+    }
+    profile->velocity = movement->velocity;
+    profile->acceleration = movement->acceleration;
+    limitToAxes(degreeChange, profile->largestDegreeChange, &profile->velocity, &profile->acceleration);
+    profile->initVelocity = planned->initVelocity;
+    profile->finalVelocity = planned->finalVelocity;
+    profile->jerk = movement->jerk;
+    profile->accelerationJerkTime = 0;
+    profile->decelerationJerkTime = 0;
+
+    // The planned velocities can only be out of reach after a crash changed the movement
+    profile->initVelocity = min(profile->initVelocity, profile->velocity);
+    profile->finalVelocity = min(profile->finalVelocity, profile->velocity);
+    profile->finalVelocity = min(profile->finalVelocity, calculateReachableVelocity(profile->initVelocity, profile->largestDegreeChange, profile->acceleration, profile->jerk, true));
+    profile->finalVelocity = max(profile->finalVelocity, calculateReachableVelocity(profile->initVelocity, profile->largestDegreeChange, profile->acceleration, profile->jerk, false));
+
+    if (profile->jerk > 0) {
+        planSCurve(profile);
+    } else {
+        profile->velocity = min(profile->velocity, sqrt(profile->largestDegreeChange * profile->acceleration + 0.5 * sq(profile->initVelocity) + 0.5 * sq(profile->finalVelocity)));
+        profile->tap = (profile->velocity / profile->acceleration) - (profile->initVelocity / profile->acceleration);
+        profile->lap = (profile->initVelocity * profile->tap) + (profile->acceleration * sq(profile->tap)) / 2.0;
+        profile->lcsp = profile->largestDegreeChange - (sq(profile->velocity) / 2.0 / profile->acceleration - sq(profile->finalVelocity) / 2.0 / profile->acceleration);
+        profile->tcsp = (profile->lcsp - profile->lap) / profile->velocity + profile->tap;
+        profile->tfin = (profile->velocity / profile->acceleration) - (profile->finalVelocity / profile->acceleration) + profile->tcsp;
+    }
+    profile->fractionPerDegree = 0;
+    if (profile->largestDegreeChange == 0)
+        profile->tfin = 0;
+    else
+        profile->fractionPerDegree = MOVEMENT_FRACTION_ONE / profile->largestDegreeChange;
+    this->planCache.store(key, *profile);
+}
+
+void EventQueue::planSCurve(MovementProfile* profile)
+{
+    double distance = profile->largestDegreeChange, jerkTime;
+    // Distance needed to speed up to a peak velocity and slow down again to the final velocity
+    auto rampDistance = [&](double velocity) {
+        double accelerationTime = calculateRampTime(velocity - profile->initVelocity, profile->acceleration, profile->jerk, &jerkTime);
+        double decelerationTime = calculateRampTime(velocity - profile->finalVelocity, profile->acceleration, profile->jerk, &jerkTime);
+        return (profile->initVelocity + velocity) / 2.0 * accelerationTime + (profile->finalVelocity + velocity) / 2.0 * decelerationTime;
+    };
+    // The peak velocity is lowered until the arm can speed up to it and slow down again within the movement
+    if (rampDistance(profile->velocity) > distance) {
+        double lowVelocity = max(profile->initVelocity, profile->finalVelocity), highVelocity = profile->velocity;
+        for (int i = 0; i < S_CURVE_SEARCH_ITERATIONS; i++) {
+            double velocity = (lowVelocity + highVelocity) / 2.0;
+            if (rampDistance(velocity) > distance)
+                highVelocity = velocity;
+            else
+                lowVelocity = velocity;
         }
+        profile->velocity = lowVelocity;
     }
 
-    this->eventStartTime = micros();
-    this->scaler = 0.0;
-    this->velocity = min(this->velocity, sqrt(this->largestDegreeChange * this->acceleration + 0.5 * sq(this->initVelocity) + 0.5 * sq(this->finalVelocity)));
+    profile->tap = calculateRampTime(profile->velocity - profile->initVelocity, profile->acceleration, profile->jerk, &profile->accelerationJerkTime);
+    profile->lap = (profile->initVelocity + profile->velocity) / 2.0 * profile->tap;
+    double decelerationDuration = calculateRampTime(profile->velocity - profile->finalVelocity, profile->acceleration, profile->jerk, &profile->decelerationJerkTime);
+    profile->lcsp = distance - (profile->finalVelocity + profile->velocity) / 2.0 * decelerationDuration;
+    profile->tcsp = profile->tap;
+    if (profile->velocity > 0)
+        profile->tcsp += max(profile->lcsp - profile->lap, 0.0) / profile->velocity;
+    profile->tfin = profile->tcsp + decelerationDuration;
+}
 
-    this->tap = (this->velocity / this->acceleration) - (this->initVelocity / this->acceleration);
-    this->lap = (this->initVelocity * this->tap) + (this->acceleration * sq(this->tap)) / 2.0;
-    this->lcsp = this->largestDegreeChange - (sq(this->velocity) / 2.0 / this->acceleration - sq(this->finalVelocity) / 2.0 / this->acceleration);
-    this->tcsp = (this->lcsp - this->lap) / this->velocity + this->tap;
-    this->tfin = (this->velocity / this->acceleration) - (this->finalVelocity / this->acceleration) + this->tcsp;
+double EventQueue::calculateRampTime(double velocityChange, double acceleration, double jerk, double* jerkTime)
+{
+    velocityChange = abs(velocityChange);
+    *jerkTime = 0;
+    if (jerk <= 0)
+        return velocityChange / acceleration;
+    // The acceleration limit is reached, so it is held between the two jerk phases
+    if (velocityChange * jerk >= sq(acceleration)) {
+        *jerkTime = acceleration / jerk;
+        return velocityChange / acceleration + *jerkTime;
+    }
+    *jerkTime = sqrt(velocityChange / jerk);
+    return 2.0 * *jerkTime;
+}
 
-    if (this->printEventInfo) {
-        Serial.print("Initial Trajectory:\t");
-        for (int i = 0; i < DOF; i++) {
-            Serial.print(String(this->initialPosition[i], 2));
-            Serial.print("\t ");
+double EventQueue::calculateReachableVelocity(double velocity, double distance, double acceleration, double jerk, bool accelerate)
+{
+    // Without a jerk limit the velocity changes at the full acceleration the whole time
+    double limit = accelerate ? sqrt(sq(velocity) + 2.0 * acceleration * distance) : sqrt(max(sq(velocity) - 2.0 * acceleration * distance, 0.0));
+    if (jerk <= 0)
+        return limit;
+    // The distance needed to change velocity is the average velocity multiplied by the time taken,
+    // so the reachable velocity is found by searching between the starting velocity and the limit
+    double jerkTime, reachable = velocity;
+    if ((velocity + limit) / 2.0 * calculateRampTime(limit - velocity, acceleration, jerk, &jerkTime) <= distance)
+        return limit;
+    for (int i = 0; i < S_CURVE_SEARCH_ITERATIONS; i++) {
+        double target = (reachable + limit) / 2.0;
+        if ((velocity + target) / 2.0 * calculateRampTime(target - velocity, acceleration, jerk, &jerkTime) > distance)
+            limit = target;
+        else
+            reachable = target;
+    }
+    return reachable;
+}
+
+double EventQueue::calculateRampPosition(double time, double startVelocity, double endVelocity, double jerkTime, double duration)
+{
+    double jerk = this->profile.jerk;
+    time = min(max(time, 0.0), duration);
+    // acceleration rising
+    if (time <= jerkTime) {
+        return startVelocity * time + jerk * time * time * time / 6.0;
+    }
+    // constant acceleration
+    if (time <= duration - jerkTime) {
+        double peakAcceleration = jerk * jerkTime;
+        double constantTime = time - jerkTime;
+        return startVelocity * jerkTime + jerk * jerkTime * jerkTime * jerkTime / 6.0
+            + (startVelocity + peakAcceleration * jerkTime / 2.0) * constantTime + peakAcceleration * constantTime * constantTime / 2.0;
+    }
+    // acceleration falling, the phase is symmetric so it is measured back from the end
+    double remainingTime = duration - time;
+    return (startVelocity + endVelocity) / 2.0 * duration - (endVelocity * remainingTime - jerk * remainingTime * remainingTime * remainingTime / 6.0);
+}
+
+void EventQueue::limitToAxes(double* degreeChange, double largestDegreeChange, double* velocity, double* acceleration)
+{
+    for (int i = 0; i < DOF; i++) {
+        if (degreeChange[i] == 0)
+            continue;
+        // The axis moves this much slower than the axis with the largest degree change
+        double ratio = largestDegreeChange / abs(degreeChange[i]);
+        if (this->motors[i].getMaxVelocity() > 0)
+            *velocity = min(*velocity, this->motors[i].getMaxVelocity() * ratio);
+        if (this->motors[i].getMaxAcceleration() > 0)
+            *acceleration = min(*acceleration, this->motors[i].getMaxAcceleration() * ratio);
+    }
+}
+
+bool EventQueue::isPlannedFrom(EventNode* event, int32_t* initialSteps)
+{
+    if (!event->isPlanned)
+        return false;
+    MovementProfile* profile = &getPlannedMovement(event)->profile;
+    for (int i = 0; i < DOF; i++) {
+        int32_t stepChange = profile->stepChange[i];
+        if (profile->directionMask & (1 << i))
+            stepChange = -stepChange;
+        if (event->movement.targetSteps[i] - stepChange != initialSteps[i])
+            return false;
+    }
+    return true;
+}
+
+double EventQueue::calculateScaler(double time)
+{
+    //acceleration phase
+    if (time <= this->profile.tap) {
+        if (this->profile.jerk > 0)
+            return calculateRampPosition(time, this->profile.initVelocity, this->profile.velocity, this->profile.accelerationJerkTime, this->profile.tap);
+        return this->profile.initVelocity * time + this->profile.acceleration * time * time / 2.0;
+    }
+    //contant maximum speed phase
+    if (time <= this->profile.tcsp) {
+        return this->profile.lap + this->profile.velocity * (time - this->profile.tap);
+    }
+    //deceleration phase
+    if (this->profile.jerk > 0) {
+        // The deceleration is the acceleration from the final velocity played backwards
+        double duration = this->profile.tfin - this->profile.tcsp;
+        return this->profile.largestDegreeChange - calculateRampPosition(this->profile.tfin - time, this->profile.finalVelocity, this->profile.velocity, this->profile.decelerationJerkTime, duration);
+    }
+    return this->profile.lcsp + this->profile.velocity * (time - this->profile.tcsp) - this->profile.acceleration * (time - this->profile.tcsp) * (time - this->profile.tcsp) / 2.0;
+}
+
+void EventQueue::planSegments()
+{
+    while (this->plannedTime < this->profile.tfin && this->stepEngine.isReady()) {
+        planNextSegment();
+    }
+}
+
+void EventQueue::planNextSegment()
+{
+    uint32_t segmentStart = this->plannedTime;
+    int64_t movementFraction;
+    if (this->profile.tfin - this->plannedTime > STEP_SEGMENT_MICROSECONDS) {
+        this->plannedTime += STEP_SEGMENT_MICROSECONDS;
+        movementFraction = min((int64_t)(calculateScaler(this->plannedTime) * this->profile.fractionPerDegree), MOVEMENT_FRACTION_ONE);
+    } else {
+        // Last segment of the movement ends exactly on the target steps
+        this->plannedTime = (uint32_t)ceil(this->profile.tfin);
+        movementFraction = MOVEMENT_FRACTION_ONE;
+    }
+    performTrajectory(max(movementFraction, (int64_t)0), this->plannedTime - segmentStart);
+}
+
+void EventQueue::performTrajectory(int64_t movementFraction, uint32_t duration)
+{
+    StepSegment segment;
+    buildSegment(movementFraction, duration, &segment);
+    this->stepEngine.addSegment(&segment);
+}
+
+void EventQueue::buildSegment(int64_t movementFraction, uint32_t duration, StepSegment* segment)
+{
+    segment->dominantSteps = 0;
+    segment->directionMask = this->profile.directionMask;
+    for (int i = 0; i < DOF; i++) {
+        segment->steps[i] = 0;
+        if (i >= DOF_ACTIVE || this->motors[i].isDisabled())
+            continue;
+        // Steps of the axis up to this point of the movement, only integer math is used
+        uint32_t stepsDone = ((uint64_t)this->profile.stepChange[i] * movementFraction) >> 32;
+        if (stepsDone > this->plannedSteps[i]) {
+            segment->steps[i] = stepsDone - this->plannedSteps[i];
+            this->plannedSteps[i] = stepsDone;
         }
-        Serial.println();
-        Serial.print("Total Movement Time:\t");
-        Serial.println(this->tfin);
-        Serial.print("Largest Degree Change:\t");
-        Serial.println(this->largestDegreeChange);
+        segment->dominantSteps = max(segment->dominantSteps, segment->steps[i]);
     }
+    // A segment without steps still takes one interrupt so that its duration passes
+    segment->interval = duration;
+    if (segment->dominantSteps > 1)
+        segment->interval = segment->interval / segment->dominantSteps;
+    segment->interval = max(segment->interval, (float)STEP_MIN_INTERVAL_MICROSECONDS);
 }
 
-void EventQueue::performTrajectory(double* updatedTrajectory)
+// +---------------------------------------------------+ //
+// |            --- Look-Ahead Planning ---            | //
+// +---------------------------------------------------+ //
+
+void EventQueue::planLookAhead()
 {
-    for (int i = 0; i < DOF_ACTIVE; i++) {
-        if (this->motors[i].getDirection() == COUNTERCLOCKWISE) {
-            while (-updatedTrajectory[i] + this->motors[i].getCurrentPositionDegrees() > this->motors[i].getDegreeChangePerStep() && !this->motors[i].isDisabled()) {
-                this->motors[i].pulse();
-            }
-        } else {
-            while (updatedTrajectory[i] - this->motors[i].getCurrentPositionDegrees() > this->motors[i].getDegreeChangePerStep() && !this->motors[i].isDisabled()) {
-                this->motors[i].pulse();
-            }
+    this->lookAheadSize = this->events.size();
+    EventNode* head = this->events.front();
+    if (head == NULL)
+        return;
+
+    // Velocities are planned along the path of the arm (the length of the change of all axes) so that
+    // movements of different shapes can be compared. A movement's own velocities are in degrees of its
+    // largest degree change, which is the path velocity divided by the scale of the movement.
+    uint32_t first = this->isRobotActive ? 1 : 0;
+    uint32_t count = this->lookAheadSize - first;
+    if (count == 0)
+        return;
+    bool previousRunning = this->isRobotActive ? head->eventCode == MOVEMENT_EVENT : !this->stepEngine.isIdle();
+    int32_t position[DOF];
+    double previousDelta[DOF], previousLength = 0, previousSpeed = 0, previousAcceleration = 0, fixedEntry = 0;
+    for (int i = 0; i < DOF; i++) {
+        if (this->isRobotActive || previousRunning)
+            position[i] = this->targetSteps[i];
+        else
+            position[i] = this->motors[i].getCurrentPositionSteps();
+        previousDelta[i] = (this->targetSteps[i] - this->initialSteps[i]) * this->motors[i].getDegreeChangePerStep();
+        previousLength += sq(previousDelta[i]);
+    }
+    previousLength = sqrt(previousLength);
+    int32_t initialSteps[DOF];
+    for (int i = 0; i < DOF; i++) {
+        initialSteps[i] = position[i];
+    }
+    if (previousRunning && this->profile.largestDegreeChange > 0) {
+        double scale = previousLength / this->profile.largestDegreeChange;
+        previousSpeed = this->profile.velocity * scale;
+        previousAcceleration = this->profile.acceleration * scale;
+        fixedEntry = this->profile.finalVelocity * scale;
+    } else {
+        previousLength = 0;
+    }
+
+    // Largest path velocity each movement can start with, the path length, the path acceleration
+    // (within the limits of the axes) and the scale of each movement
+    float entry[EVENT_QUEUE_SIZE], pathLength[EVENT_QUEUE_SIZE], pathAcceleration[EVENT_QUEUE_SIZE], scale[EVENT_QUEUE_SIZE];
+    for (uint32_t j = 0; j < count; j++) {
+        EventNode* event = this->events.at(first + j);
+        double delta[DOF], length = 0, largestChange = 0;
+        for (int i = 0; i < DOF; i++) {
+            delta[i] = 0;
+            if (event->eventCode == SLEEP_EVENT || event->eventCode == STREAM_EVENT)
+                continue;
+            delta[i] = (event->movement.targetSteps[i] - position[i]) * this->motors[i].getDegreeChangePerStep();
+            position[i] = event->movement.targetSteps[i];
+            length += sq(delta[i]);
+            largestChange = max(largestChange, abs(delta[i]));
+        }
+        length = sqrt(length);
+        entry[j] = 0;
+        pathLength[j] = 0;
+        pathAcceleration[j] = 0;
+        scale[j] = 0;
+        if (event->eventCode != MOVEMENT_EVENT || largestChange == 0) {
+            // Sleeping, homing, streams and empty movements start and end at rest
+            previousLength = 0;
+            continue;
         }
+        scale[j] = length / largestChange;
+        double velocity = event->movement.velocity, acceleration = event->movement.acceleration;
+        limitToAxes(delta, largestChange, &velocity, &acceleration);
+        double speed = velocity * scale[j];
+        acceleration *= scale[j];
+        pathLength[j] = length;
+        pathAcceleration[j] = acceleration;
+        if (!event->useEncoderPosition && previousLength > 0) {
+            double junction = calculateJunctionVelocity(previousDelta, previousLength, delta, length, min(acceleration, previousAcceleration));
+            entry[j] = (j == 0) ? fixedEntry : min(junction, min(speed, previousSpeed));
+        }
+        for (int i = 0; i < DOF; i++) {
+            previousDelta[i] = delta[i];
+        }
+        previousLength = length;
+        previousSpeed = speed;
+        previousAcceleration = acceleration;
+    }
+
+    // The last movement has to stop, so each movement can only start as fast as it is able to slow down
+    // to the start of the next one. The first movement already has its velocity set by the movement before it.
+    for (uint32_t j = count - 1; j > 0; j--) {
+        EventNode* event = this->events.at(first + j);
+        float exit = (j + 1 < count) ? entry[j + 1] : 0;
+        if (event->eventCode == MOVEMENT_EVENT)
+            entry[j] = min(entry[j], (float)calculateReachableVelocity(exit, pathLength[j], pathAcceleration[j], event->movement.jerk * scale[j], true));
     }
+
+    // Each movement can only end as fast as it is able to speed up to. The profile of a movement
+    // is only worked out again if its start or its velocities have changed, and only the movements
+    // that fit in the profile table are planned.
+    for (uint32_t j = 0; j < count && first + j < LOOK_AHEAD_PROFILES; j++) {
+        EventNode* event = this->events.at(first + j);
+        float exit = (j + 1 < count) ? entry[j + 1] : 0;
+        double acceleration = pathAcceleration[j], jerk = 0;
+        if (event->eventCode == MOVEMENT_EVENT)
+            jerk = event->movement.jerk * scale[j];
+        exit = min(exit, (float)calculateReachableVelocity(entry[j], pathLength[j], acceleration, jerk, true));
+        exit = max(exit, (float)calculateReachableVelocity(entry[j], pathLength[j], acceleration, jerk, false));
+        if (j + 1 < count)
+            entry[j + 1] = exit;
+        if (event->eventCode == SLEEP_EVENT || event->eventCode == STREAM_EVENT)
+            continue;
+        // Homing starts and ends at rest
+        PlannedMovement* planned = getPlannedMovement(event);
+        float initVelocity = (event->eventCode == MOVEMENT_EVENT && scale[j] > 0) ? entry[j] / scale[j] : 0;
+        float finalVelocity = (event->eventCode == MOVEMENT_EVENT && scale[j] > 0) ? exit / scale[j] : 0;
+        if (!event->isPlanned || initVelocity != planned->initVelocity || finalVelocity != planned->finalVelocity) {
+            planned->initVelocity = initVelocity;
+            planned->finalVelocity = finalVelocity;
+            event->isPlanned = false;
+        }
+        if (!isPlannedFrom(event, initialSteps)) {
+            planMovement(&event->movement, initialSteps, planned);
+            event->isPlanned = true;
+        }
+        for (int i = 0; i < DOF; i++) {
+            initialSteps[i] = event->movement.targetSteps[i];
+        }
+    }
+}
+
+double EventQueue::calculateJunctionVelocity(double* previousDelta, double previousLength, double* delta, double length, double acceleration)
+{
+    double cosTheta = 0;
+    for (int i = 0; i < DOF; i++) {
+        cosTheta -= previousDelta[i] * delta[i];
+    }
+    cosTheta /= previousLength * length;
+    // The arm reverses, so it has to stop
+    if (cosTheta > 0.999999)
+        return 0;
+    // The arm keeps going straight, so only the velocity of the movements limits it
+    if (cosTheta < -0.999999)
+        return MAX_VELOCITY * DOF;
+    double sinHalfTheta = sqrt(0.5 * (1.0 - cosTheta));
+    return sqrt(acceleration * JUNCTION_DEVIATION * sinHalfTheta / (1.0 - sinHalfTheta));
 }
 
 // +---------------------------------------------------+ //
 // |                --- Sleep Event ---                | //
 // +---------------------------------------------------+ //
 
-void EventQueue::addSleepEvent(uint32_t sleepTime)
+bool EventQueue::addSleepEvent(uint32_t sleepTime)
+{
+    EventNode* newEvent = reserveEvent();
+    if (newEvent == NULL)
+        return false;
+    setSleepEvent(newEvent, sleepTime);
+    commitEvent();
+    return true;
+}
+
+void EventQueue::setSleepEvent(EventNode* event, uint32_t sleepTime)
 {
     if (this->printEventInfo) {
         Serial.print("Sleep Event Added: ");
         Serial.print(sleepTime / SECONDS_TO_MICROSECONDS);
         Serial.println(" Seconds");
     }
-    EventNode* newEvent = (EventNode*)malloc(sizeof(EventNode));
-    newEvent->eventCode = SLEEP_EVENT;
-    newEvent->timeVariable = sleepTime;
-    addEvent(newEvent);
+    event->eventCode = SLEEP_EVENT;
+    event->sleep.sleepTime = sleepTime;
 }
 
 void EventQueue::processSleepEvent()
 {
+    EventNode* event = this->events.front();
     if (!this->isRobotActive) {
         this->eventStartTime = micros();
         this->isRobotActive = true;
         if (printEventInfo) {
             Serial.print("Sleep Event Started: ");
-            Serial.print(this->head->timeVariable / SECONDS_TO_MICROSECONDS);
+            Serial.print(event->sleep.sleepTime / SECONDS_TO_MICROSECONDS);
             Serial.println(" Seconds!");
         }
     }
-    if (this->eventStartTime + this->head->timeVariable < micros()) {
+    if (this->eventStartTime + event->sleep.sleepTime < micros()) {
         if (printEventInfo) {
             Serial.print("Slept for ");
-            Serial.print(this->head->timeVariable / SECONDS_TO_MICROSECONDS);
+            Serial.print(event->sleep.sleepTime / SECONDS_TO_MICROSECONDS);
             Serial.println(" Seconds!");
         }
         eventCompleted();
@@ -337,11 +860,19 @@ void EventQueue::processSleepEvent()
 // |                --- Homing Event ---               | //
 // +---------------------------------------------------+ //
 
-void EventQueue::addHomingEvent(double velocity, double acceleration)
+bool EventQueue::addHomingEvent(double velocity, double acceleration)
+{
+    EventNode* newEvent = reserveEvent();
+    if (newEvent == NULL || !setHomingEvent(newEvent, velocity, acceleration))
+        return false;
+    commitEvent();
+    return true;
+}
+
+bool EventQueue::setHomingEvent(EventNode* event, double velocity, double acceleration)
 {
     double homingMovement[DOF] = { -345.0, -200.0, -280.0, -280.0, -180.0, -360.0 };
-    this->addMovementEvent(homingMovement, velocity, acceleration, 0, 0, false);
-    this->tail->eventCode = HOMING_EVENT;
+    return setMovementEvent(event, HOMING_EVENT, homingMovement, velocity, acceleration, false, 0);
 }
 
 void EventQueue::processHomingEvent()
@@ -352,28 +883,296 @@ void EventQueue::processHomingEvent()
         calculateMovementEvent();
     }
 
-    uint32_t currentTime = micros();
-    if (currentTime - this->eventStartTime <= this->tfin) {
-        timeDelta = currentTime - this->eventStartTime;
-        //acceleration phase
-        if (timeDelta <= this->tap) {
-            this->scaler = this->initVelocity * this->timeDelta + this->acceleration * this->timeDelta * this->timeDelta / 2.0;
+    planSegments();
+    if (this->plannedTime >= this->profile.tfin && this->stepEngine.isIdle()) {
+        eventCompleted();
+    }
+}
+
+// +---------------------------------------------------+ //
+// |                --- Stream Event ---               | //
+// +---------------------------------------------------+ //
+
+bool EventQueue::addStreamEvent(uint32_t playbackDelay, uint8_t interpolation)
+{
+    EventNode* newEvent = reserveEvent();
+    if (newEvent == NULL || !setStreamEvent(newEvent, playbackDelay, interpolation))
+        return false;
+    commitEvent();
+    return true;
+}
+
+bool EventQueue::setStreamEvent(EventNode* event, uint32_t playbackDelay, uint8_t interpolation)
+{
+    if (interpolation != STREAM_LINEAR && interpolation != STREAM_CUBIC) {
+        this->errorCode = INVALID_INTERPOLATION;
+        return false;
+    }
+    event->eventCode = STREAM_EVENT;
+    event->useEncoderPosition = false;
+    event->stream.playbackDelay = playbackDelay;
+    event->stream.interpolation = interpolation;
+    return true;
+}
+
+bool EventQueue::addSetpoint(uint32_t timestamp, double* position, bool isEnd)
+{
+    Setpoint* setpoint = reserveSetpoint();
+    if (setpoint == NULL)
+        return false;
+    setpoint->timestamp = timestamp;
+    for (int i = 0; i < DOF; i++) {
+        setpoint->position[i] = position[i];
+    }
+    setpoint->flags = isEnd ? SETPOINT_END_OF_STREAM : 0;
+    if (!checkSetpoint(setpoint))
+        return false;
+    commitSetpoints();
+    return true;
+}
+
+Setpoint* EventQueue::reserveSetpoint(uint32_t index)
+{
+    return this->setpoints.reserve(index);
+}
+
+void EventQueue::commitSetpoints(uint32_t count)
+{
+    this->setpoints.commit(count);
+}
+
+bool EventQueue::checkSetpoint(Setpoint* setpoint)
+{
+    for (int i = 0; i < DOF; i++) {
+        if (this->motors[i].getMaximumPosition() != -1 && (this->motors[i].getMaximumPosition() * this->motors[i].getDegreeChangePerStep() < setpoint->position[i] || setpoint->position[i] < 0)) {
+            this->errorCode = OUTSIDE_OF_MOTOR_BOUNDS;
+            return false;
+        }
+    }
+    return true;
+}
+
+void EventQueue::processStreamEvent()
+{
+    StreamEvent* stream = &this->events.front()->stream;
+    if (!this->isRobotActive) {
+        // The stream starts from where the arm is, so the steps of the previous movement have to be done
+        if (!this->stepEngine.isIdle())
+            return;
+        this->isRobotActive = true;
+        this->isRobotMoving = true;
+        this->streamState = STREAM_STARTING;
+        this->streamWaitTime = micros();
+        this->streamCrashed = false;
+        for (int i = 0; i < DOF; i++) {
+            this->streamSteps[i] = this->motors[i].getCurrentPositionSteps();
         }
-        //contant maximum speed phase
-        if (timeDelta > this->tap && timeDelta <= this->tcsp) {
-            this->scaler = this->lap + this->velocity * (timeDelta - this->tap);
+    }
+
+    if (this->streamState == STREAM_STARTING || this->streamState == STREAM_BUFFERING)
+        bufferSetpoints(stream);
+    while (this->streamState == STREAM_PLAYING && this->stepEngine.getBufferedSegments() < STREAM_LEAD_SEGMENTS) {
+        if (!planStreamSegment(stream))
+            break;
+    }
+
+    if (this->streamState != STREAM_FINISHED) {
+        EncoderSnapshot snapshot;
+        readEncoderSnapshot(this->motors, &snapshot);
+        for (int i = 0; i < DOF_ACTIVE; i++) {
+            if (!this->motors[i].comparePositionToEncoder(snapshot.steps[i])) {
+                // The segments already planned are only a few milliseconds, so the arm is left to finish
+                // them and the rest of the stream is dropped
+                this->streamState = STREAM_FINISHED;
+                this->streamCrashed = true;
+                while (!this->setpoints.isEmpty())
+                    this->setpoints.pop();
+                break;
+            }
         }
-        //deceleration phase
-        if (timeDelta > tcsp) {
-            this->scaler = this->lcsp + this->velocity * (timeDelta - this->tcsp) - this->acceleration * (timeDelta - this->tcsp) * (timeDelta - this->tcsp) / 2.0;
+    }
+    if (this->streamState != STREAM_FINISHED || !this->stepEngine.isIdle())
+        return;
+
+    if (this->streamCrashed) {
+        EncoderSnapshot snapshot;
+        readEncoderSnapshot(this->motors, &snapshot);
+        for (int i = 0; i < DOF; i++) {
+            this->motors[i].setCurrentPosition(snapshot.steps[i]);
         }
-        //trajectory x and y as a function of scalar
-        double updatedTrajectory[6];
+    }
+    // The movements after the stream are planned from where it ended
+    for (int i = 0; i < DOF; i++) {
+        this->initialSteps[i] = this->motors[i].getCurrentPositionSteps();
+        this->targetSteps[i] = this->initialSteps[i];
+    }
+    this->streamState = STREAM_NONE;
+    eventCompleted();
+}
+
+bool EventQueue::bufferSetpoints(StreamEvent* stream)
+{
+    uint32_t buffered = this->setpoints.size();
+    bool isReady = false;
+    if (buffered > 0) {
+        Setpoint* newest = this->setpoints.at(buffered - 1);
+        bool isEnd = newest->flags & SETPOINT_END_OF_STREAM;
+        if (this->streamState == STREAM_STARTING)
+            this->streamTime = this->setpoints.front()->timestamp;
+        // Last stream time a segment can be planned from, cubic interpolation also needs the setpoint after the segment
+        uint32_t playableTime = newest->timestamp - STEP_SEGMENT_MICROSECONDS;
+        if (stream->interpolation == STREAM_CUBIC && !isEnd)
+            playableTime = (buffered > 1) ? this->setpoints.at(buffered - 2)->timestamp - STEP_SEGMENT_MICROSECONDS : this->streamTime - 1;
+        // A full ring or the end of the stream starts it early, since no more of the delay can be buffered
+        isReady = isEnd
+            || (((int32_t)(newest->timestamp - this->streamTime) >= (int32_t)stream->playbackDelay || this->setpoints.isFull())
+                && (int32_t)(playableTime - this->streamTime) >= 0);
+        // After running out the stream skips ahead, so the arm does not fall further behind the computer
+        uint32_t delayedTime = newest->timestamp - stream->playbackDelay;
+        if (!isEnd && (int32_t)(delayedTime - playableTime) > 0)
+            delayedTime = playableTime;
+        if (isReady && (int32_t)(delayedTime - this->streamTime) > 0)
+            this->streamTime = delayedTime;
+    }
+    if (!isReady) {
+        if (micros() - this->streamWaitTime > STREAM_TIMEOUT_MICROSECONDS)
+            this->streamState = STREAM_FINISHED;
+        return false;
+    }
+
+    // The arm is held where it is up to the stream time, then moves towards the setpoints after it
+    for (int j = 0; j < 2; j++) {
+        this->streamPoints[j].time = this->streamTime;
+        this->streamPoints[j].isEnd = false;
         for (int i = 0; i < DOF; i++) {
-            updatedTrajectory[i] = this->initialPosition[i] + (this->targetPosition[i] - this->initialPosition[i]) / this->largestDegreeChange * this->scaler;
+            this->streamPoints[j].steps[i] = this->streamSteps[i];
+        }
+    }
+    this->streamState = STREAM_PLAYING;
+    return true;
+}
+
+bool EventQueue::planStreamSegment(StreamEvent* stream)
+{
+    // The clocks of the computer and the arm never run at exactly the same rate, so the stream time is
+    // moved slowly towards the playback delay behind the newest setpoint to keep the latency from drifting
+    int32_t drift = 0;
+    uint32_t buffered = this->setpoints.size();
+    if (buffered > 0 && !(this->setpoints.at(buffered - 1)->flags & SETPOINT_END_OF_STREAM)) {
+        drift = ((int32_t)(this->setpoints.at(buffered - 1)->timestamp - this->streamTime) - (int32_t)stream->playbackDelay) / STREAM_DRIFT_SEGMENTS;
+        drift = min(max(drift, (int32_t)-STREAM_MAX_DRIFT_MICROSECONDS), (int32_t)STREAM_MAX_DRIFT_MICROSECONDS);
+    }
+    uint32_t segmentEnd = this->streamTime + STEP_SEGMENT_MICROSECONDS + drift;
+    StreamPoint* current = &this->streamPoints[1];
+    // The setpoints passed by the end of the segment become the setpoints it is interpolated from,
+    // setpoints that are not after the last one are dropped
+    Setpoint* next;
+    while (!current->isEnd && (next = this->setpoints.front()) != NULL && (int32_t)(next->timestamp - segmentEnd) < 0) {
+        if ((int32_t)(next->timestamp - current->time) > 0) {
+            this->streamPoints[0] = *current;
+            loadStreamPoint(next, current);
+        }
+        this->setpoints.pop();
+    }
+
+    double target[DOF];
+    if (current->isEnd) {
+        // The last setpoint is held until every axis has caught up with it
+        bool isReached = true;
+        for (int i = 0; i < DOF_ACTIVE; i++) {
+            target[i] = current->steps[i];
+            if (!this->motors[i].isDisabled() && lround(target[i]) != this->streamSteps[i])
+                isReached = false;
+        }
+        if (isReached) {
+            this->streamState = STREAM_FINISHED;
+            return false;
         }
-        performTrajectory(updatedTrajectory);
     } else {
-        eventCompleted();
+        next = this->setpoints.front();
+        Setpoint* after = this->setpoints.at(1);
+        bool isCubic = stream->interpolation == STREAM_CUBIC;
+        if (next == NULL || (isCubic && after == NULL && !(next->flags & SETPOINT_END_OF_STREAM))) {
+            // The stream ran out of setpoints, the arm stops once the planned segments are done
+            if (this->stepEngine.getBufferedSegments() == 0) {
+                this->streamUnderruns++;
+                this->streamState = STREAM_BUFFERING;
+                this->streamWaitTime = micros();
+            }
+            return false;
+        }
+        StreamPoint following[2];
+        loadStreamPoint(next, &following[0]);
+        if (isCubic)
+            loadStreamPoint(after != NULL && !following[0].isEnd ? after : next, &following[1]);
+        StreamPoint* points[4] = { &this->streamPoints[0], current, &following[0], isCubic ? &following[1] : &following[0] };
+        interpolateStream(points, segmentEnd, stream->interpolation, target);
+    }
+
+    StepSegment segment;
+    buildStreamSegment(target, STEP_SEGMENT_MICROSECONDS, &segment);
+    this->stepEngine.addSegment(&segment);
+    this->streamTime = segmentEnd;
+    return true;
+}
+
+void EventQueue::loadStreamPoint(Setpoint* setpoint, StreamPoint* point)
+{
+    point->time = setpoint->timestamp;
+    point->isEnd = setpoint->flags & SETPOINT_END_OF_STREAM;
+    for (int i = 0; i < DOF; i++) {
+        point->steps[i] = setpoint->position[i] / this->motors[i].getDegreeChangePerStep();
     }
-}
\ No newline at end of file
+}
+
+void EventQueue::interpolateStream(StreamPoint** points, uint32_t time, uint8_t interpolation, double* target)
+{
+    StreamPoint *before = points[0], *from = points[1], *to = points[2], *after = points[3];
+    double duration = (int32_t)(to->time - from->time);
+    double u = (duration > 0) ? (int32_t)(time - from->time) / duration : 1.0;
+    u = min(max(u, 0.0), 1.0);
+    if (interpolation == STREAM_LINEAR) {
+        for (int i = 0; i < DOF; i++) {
+            target[i] = from->steps[i] + (to->steps[i] - from->steps[i]) * u;
+        }
+        return;
+    }
+    // Hermite basis functions, the slopes are scaled by the duration since u runs from 0 to 1
+    double u2 = u * u, u3 = u2 * u;
+    double h00 = 2 * u3 - 3 * u2 + 1, h10 = u3 - 2 * u2 + u, h01 = -2 * u3 + 3 * u2, h11 = u3 - u2;
+    double fromSpan = (int32_t)(to->time - before->time), toSpan = (int32_t)(after->time - from->time);
+    for (int i = 0; i < DOF; i++) {
+        double fromSlope = (fromSpan > 0) ? (to->steps[i] - before->steps[i]) / fromSpan : 0;
+        double toSlope = (toSpan > 0) ? (after->steps[i] - from->steps[i]) / toSpan : 0;
+        target[i] = h00 * from->steps[i] + h10 * duration * fromSlope + h01 * to->steps[i] + h11 * duration * toSlope;
+    }
+}
+
+void EventQueue::buildStreamSegment(double* target, uint32_t duration, StepSegment* segment)
+{
+    segment->dominantSteps = 0;
+    segment->directionMask = this->streamDirections;
+    int32_t engineLimit = duration / STEP_MIN_INTERVAL_MICROSECONDS;
+    for (int i = 0; i < DOF; i++) {
+        segment->steps[i] = 0;
+        if (i >= DOF_ACTIVE || this->motors[i].isDisabled())
+            continue;
+        double maxVelocity = (this->motors[i].getMaxVelocity() > 0) ? this->motors[i].getMaxVelocity() : MAX_VELOCITY;
+        int32_t limit = min(engineLimit, (int32_t)(maxVelocity * duration / this->motors[i].getDegreeChangePerStep()));
+        int32_t change = lround(target[i]) - this->streamSteps[i];
+        change = min(max(change, -limit), limit);
+        // An axis that does not move keeps its direction so its pin is not written
+        if (change < 0)
+            segment->directionMask |= 1 << i;
+        else if (change > 0)
+            segment->directionMask &= ~(1 << i);
+        segment->steps[i] = abs(change);
+        this->streamSteps[i] += change;
+        segment->dominantSteps = max(segment->dominantSteps, segment->steps[i]);
+    }
+    this->streamDirections = segment->directionMask;
+    // A segment without steps still takes one interrupt so that its duration passes
+    segment->interval = duration;
+    if (segment->dominantSteps > 1)
+        segment->interval = segment->interval / segment->dominantSteps;
+}
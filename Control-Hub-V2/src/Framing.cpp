@@ -0,0 +1,82 @@
+/**
+ * This file is associated with Framing.h. It contains the CRC and the COBS encoding used to frame
+ * the data sent over the serial port.
+ *
+ * @author Thomas Batchelder
+ * @file Framing.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#include "../include/Framing.h"
+
+uint16_t calculateCrc16(const uint8_t* data, size_t length)
+{
+    uint16_t crc = FRAME_CRC_INITIAL;
+    for (size_t i = 0; i < length; i++)
+        crc = updateCrc16(crc, data[i]);
+    return crc;
+}
+
+uint16_t updateCrc16(uint16_t crc, uint8_t value)
+{
+    crc ^= (uint16_t)value << 8;
+    for (int bit = 0; bit < 8; bit++)
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    return crc;
+}
+
+void resetCobs(CobsDecoder* decoder)
+{
+    decoder->blockRemaining = 0;
+    decoder->zeroPending = false;
+}
+
+bool decodeCobs(CobsDecoder* decoder, uint8_t value, uint8_t* output)
+{
+    if (decoder->blockRemaining > 0) {
+        decoder->blockRemaining--;
+        *output = value;
+        return true;
+    }
+    // The byte starts a new block, the zero ending the previous block is only decoded now since the last block has none
+    bool hasZero = decoder->zeroPending;
+    decoder->blockRemaining = value - 1;
+    decoder->zeroPending = value != 0xFF;
+    *output = 0;
+    return hasZero;
+}
+
+bool isCobsComplete(CobsDecoder* decoder)
+{
+    return decoder->blockRemaining == 0;
+}
+
+size_t encodeCobs(const uint8_t* data, size_t length, uint8_t* output)
+{
+    size_t codeIndex = 0, writeIndex = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] != 0) {
+            output[writeIndex++] = data[i];
+            code++;
+        }
+        if (data[i] == 0 || code == 0xFF) {
+            output[codeIndex] = code;
+            codeIndex = writeIndex++;
+            code = 1;
+        }
+    }
+    output[codeIndex] = code;
+    return writeIndex;
+}
+
+size_t encodeFrame(uint8_t* frame, size_t length, uint8_t* output)
+{
+    uint16_t crc = calculateCrc16(frame, length);
+    frame[length] = crc & 0xFF;
+    frame[length + 1] = crc >> 8;
+    size_t encodedLength = encodeCobs(frame, length + FRAME_CRC_SIZE, output + 1) + 2;
+    output[0] = FRAME_DELIMITER;
+    output[encodedLength - 1] = FRAME_DELIMITER;
+    return encodedLength;
+}
@@ -0,0 +1,69 @@
+/**
+ * This file is associated with LimitSwitchSampler.h. The sampler reads every limit switch from a
+ * timer interrupt and debounces each one with a shift register filter.
+ *
+ * @author Thomas Batchelder
+ * @file LimitSwitchSampler.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#include "../include/LimitSwitchSampler.h"
+
+/** Number of pressed readings in the history needed to report a switch as pressed */
+#define LIMIT_SWITCH_PRESS_COUNT ((int)(LIMIT_SWITCH_SAMPLES * LIMIT_SWITCH_PRESS_RATIO + 0.5))
+/** Number of pressed readings in the history at or below which a switch is reported as released */
+#define LIMIT_SWITCH_RELEASE_COUNT ((int)(LIMIT_SWITCH_SAMPLES * LIMIT_SWITCH_RELEASE_RATIO + 0.5))
+
+LimitSwitchSampler* LimitSwitchSampler::activeSampler = NULL;
+
+LimitSwitchSampler::LimitSwitchSampler(uint8_t* limPins)
+{
+    for (int i = 0; i < DOF; i++) {
+        this->limPins[i] = limPins[i];
+        this->sampleHistory[i] = 0;
+    }
+    this->limitMask = 0;
+}
+
+void LimitSwitchSampler::begin()
+{
+    activeSampler = this;
+    this->timer.begin(timerInterrupt, LIMIT_SWITCH_SAMPLE_MICROSECONDS);
+}
+
+void LimitSwitchSampler::timerInterrupt()
+{
+    if (activeSampler != NULL)
+        activeSampler->sample();
+}
+
+void LimitSwitchSampler::sample()
+{
+    uint8_t mask = this->limitMask;
+    for (int i = 0; i < DOF; i++) {
+        uint16_t history = (this->sampleHistory[i] << 1) | (digitalReadFast(this->limPins[i]) ? 1 : 0);
+        if (LIMIT_SWITCH_SAMPLES < 16)
+            history &= (1u << LIMIT_SWITCH_SAMPLES) - 1;
+        this->sampleHistory[i] = history;
+
+        // The gap between the press and release counts keeps a noisy switch from chattering
+        int pressedCount = __builtin_popcount(history);
+        if (pressedCount >= LIMIT_SWITCH_PRESS_COUNT)
+            mask |= 1 << i;
+        else if (pressedCount <= LIMIT_SWITCH_RELEASE_COUNT)
+            mask &= ~(1 << i);
+    }
+    this->limitMask = mask;
+}
+
+uint8_t LimitSwitchSampler::getLimitMask()
+{
+    return this->limitMask;
+}
+
+void LimitSwitchSampler::poll()
+{
+#ifndef ARDUINO
+    this->timer.poll();
+#endif
+}
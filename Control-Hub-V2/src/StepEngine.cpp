@@ -0,0 +1,159 @@
+/**
+ * This file is associated with StepEngine.h. The step engine is responsible for sending step
+ * pulses to the motors from a timer interrupt so that the timing of each step does not depend
+ * on how often the main loop runs. The steps of all axes are interleaved using a Bresenham
+ * error term driven by the dominant axis of each segment.
+ *
+ * @author Thomas Batchelder
+ * @file StepEngine.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#include "../include/StepEngine.h"
+
+StepEngine* StepEngine::activeEngine = NULL;
+
+StepEngine::StepEngine(Stepper* motors)
+{
+    this->motors = motors;
+    uint8_t stepPins[DOF], dirPins[DOF];
+    for (int i = 0; i < DOF; i++) {
+        this->segmentSteps[i] = 0;
+        this->stepError[i] = 0;
+        stepPins[i] = motors[i].getStepPin();
+        dirPins[i] = motors[i].getDirPin();
+    }
+    this->output = StepOutput(stepPins, dirPins);
+}
+
+void StepEngine::timerInterrupt()
+{
+    if (activeEngine != NULL)
+        activeEngine->tick();
+}
+
+void StepEngine::tick()
+{
+    if (!this->segmentActive) {
+        loadSegment();
+        return;
+    }
+
+    // The dominant axis steps on every interrupt, the other axes step when their error overflows.
+    // The loop over the axes is unrolled at compile time so every index and axis setting is a constant.
+    uint8_t stepMask = 0;
+    forEachAxis<DOF_ACTIVE>([&](auto axis) {
+        typedef AxisConfig<decltype(axis)::value> Config;
+        const int i = Config::axis;
+        if (this->segmentSteps[i] == 0)
+            return;
+        this->stepError[i] += this->segmentSteps[i];
+        if (this->stepError[i] >= this->dominantSteps) {
+            this->stepError[i] -= this->dominantSteps;
+            if (this->motors[i].template takeStep<Config>())
+                stepMask |= 1 << i;
+        }
+    });
+#ifdef RUN_BENCHMARKS
+    StepRecorder::record(stepMask, this->segmentInterval);
+#endif
+    if (stepMask != 0)
+        this->output.pulse(stepMask);
+
+    // A segment without steps still takes one interrupt so that its duration passes
+    this->stepCount++;
+    if (this->stepCount >= this->dominantSteps && !loadSegment()) {
+        this->segmentActive = false;
+        this->timer.begin(timerInterrupt, STEP_TICK_MICROSECONDS);
+    }
+}
+
+bool StepEngine::loadSegment()
+{
+    if (this->bufferHead == this->bufferTail)
+        return false;
+    StepSegment* segment = &this->segmentBuffer[this->bufferHead];
+    this->dominantSteps = segment->dominantSteps;
+    this->stepCount = 0;
+    this->segmentInterval = segment->interval;
+    // The directions only change between movements, so the pins are rarely written
+    if (segment->directionMask != this->currentDirections)
+        setDirections(segment->directionMask);
+    for (int i = 0; i < DOF; i++) {
+        this->segmentSteps[i] = segment->steps[i];
+        this->stepError[i] = segment->dominantSteps / 2;
+    }
+    // The timer is restarted rather than updated since an updated period only starts after the next interrupt
+    this->timer.begin(timerInterrupt, segment->interval);
+    this->bufferHead = (this->bufferHead + 1) % STEP_SEGMENT_BUFFER_SIZE;
+    this->segmentActive = true;
+    return true;
+}
+
+void StepEngine::setDirections(uint8_t directionMask)
+{
+    for (int i = 0; i < DOF; i++) {
+        this->motors[i].setDirection((directionMask & (1 << i)) != 0, false);
+    }
+    this->currentDirections = directionMask;
+    this->output.writeDirections(directionMask);
+}
+
+bool StepEngine::addSegment(StepSegment* segment)
+{
+    uint8_t nextTail = (this->bufferTail + 1) % STEP_SEGMENT_BUFFER_SIZE;
+    if (nextTail == this->bufferHead)
+        return false;
+    this->segmentBuffer[this->bufferTail] = *segment;
+    noInterrupts();
+    this->bufferTail = nextTail;
+    interrupts();
+
+    if (!this->timerRunning) {
+        activeEngine = this;
+        this->timerRunning = this->timer.begin(timerInterrupt, STEP_TICK_MICROSECONDS);
+    }
+    return true;
+}
+
+bool StepEngine::isReady()
+{
+    return (this->bufferTail + 1) % STEP_SEGMENT_BUFFER_SIZE != this->bufferHead;
+}
+
+bool StepEngine::isIdle()
+{
+    return !this->segmentActive && this->bufferHead == this->bufferTail;
+}
+
+uint8_t StepEngine::getBufferedSegments()
+{
+    return (this->bufferTail + STEP_SEGMENT_BUFFER_SIZE - this->bufferHead) % STEP_SEGMENT_BUFFER_SIZE;
+}
+
+void StepEngine::writeDirections()
+{
+    this->currentDirections = 0;
+    for (int i = 0; i < DOF; i++) {
+        if (this->motors[i].getDirection() == COUNTERCLOCKWISE)
+            this->currentDirections |= 1 << i;
+    }
+    this->output.writeDirections(this->currentDirections);
+}
+
+void StepEngine::stop()
+{
+    noInterrupts();
+    this->bufferHead = this->bufferTail;
+    this->segmentActive = false;
+    if (this->timerRunning)
+        this->timer.begin(timerInterrupt, STEP_TICK_MICROSECONDS);
+    interrupts();
+}
+
+void StepEngine::poll()
+{
+#ifndef ARDUINO
+    this->timer.poll();
+#endif
+}
@@ -0,0 +1,100 @@
+/**
+ * This file is associated with StepOutput.h. The step output layer writes the step and direction
+ * pins of all axes that share a GPIO port with a single write to the set and clear registers.
+ *
+ * @author Thomas Batchelder
+ * @file StepOutput.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#include "../include/StepOutput.h"
+
+StepOutput::StepOutput(uint8_t* stepPins, uint8_t* dirPins)
+{
+    this->portCount = 0;
+    for (int i = 0; i < DOF; i++) {
+        this->stepPort[i] = findPort(stepPins[i]);
+        this->dirPort[i] = findPort(dirPins[i]);
+#ifdef ARDUINO
+        this->stepBit[i] = digitalPinToBitMask(stepPins[i]);
+        this->dirBit[i] = digitalPinToBitMask(dirPins[i]);
+#else
+        this->stepBit[i] = 1ul << (stepPins[i] % 32);
+        this->dirBit[i] = 1ul << (dirPins[i] % 32);
+#endif
+    }
+}
+
+uint8_t StepOutput::findPort(uint8_t pin)
+{
+    OutputPort port;
+#ifdef ARDUINO
+    port.setRegister = portSetRegister(pin);
+    port.clearRegister = portClearRegister(pin);
+    for (uint8_t i = 0; i < this->portCount; i++) {
+        if (this->ports[i].setRegister == port.setRegister)
+            return i;
+    }
+#else
+    port.hostPort = hostPinPort(pin);
+    for (uint8_t i = 0; i < this->portCount; i++) {
+        if (this->ports[i].hostPort == port.hostPort)
+            return i;
+    }
+#endif
+    this->ports[this->portCount] = port;
+    return this->portCount++;
+}
+
+void StepOutput::writeSet(uint32_t* portMasks)
+{
+    for (uint8_t i = 0; i < this->portCount; i++) {
+        if (portMasks[i] == 0)
+            continue;
+#ifdef ARDUINO
+        *this->ports[i].setRegister = portMasks[i];
+#else
+        hostGpioSet(this->ports[i].hostPort, portMasks[i]);
+#endif
+    }
+}
+
+void StepOutput::writeClear(uint32_t* portMasks)
+{
+    for (uint8_t i = 0; i < this->portCount; i++) {
+        if (portMasks[i] == 0)
+            continue;
+#ifdef ARDUINO
+        *this->ports[i].clearRegister = portMasks[i];
+#else
+        hostGpioClear(this->ports[i].hostPort, portMasks[i]);
+#endif
+    }
+}
+
+void StepOutput::pulse(uint8_t axisMask)
+{
+    uint32_t portMasks[MAX_OUTPUT_PORTS] = { 0 };
+    for (int i = 0; i < DOF; i++) {
+        if (axisMask & (1 << i))
+            portMasks[this->stepPort[i]] |= this->stepBit[i];
+    }
+    writeSet(portMasks);
+    delayMicroseconds(STEP_PULSE_MICROSECONDS);
+    writeClear(portMasks);
+}
+
+void StepOutput::writeDirections(uint8_t counterClockwiseMask)
+{
+    uint8_t highMask = counterClockwiseMask ^ directionInvertMask();
+    uint32_t setMasks[MAX_OUTPUT_PORTS] = { 0 };
+    uint32_t clearMasks[MAX_OUTPUT_PORTS] = { 0 };
+    for (int i = 0; i < DOF; i++) {
+        if (highMask & (1 << i))
+            setMasks[this->dirPort[i]] |= this->dirBit[i];
+        else
+            clearMasks[this->dirPort[i]] |= this->dirBit[i];
+    }
+    writeSet(setMasks);
+    writeClear(clearMasks);
+}
@@ -0,0 +1,87 @@
+/**
+ * This file is associated with StepRecorder.h. The step recorder keeps the time of every
+ * interrupt of the step engine so the benchmarks can measure the step rate and jitter.
+ *
+ * @author Thomas Batchelder
+ * @file StepRecorder.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#include "../include/StepRecorder.h"
+
+StepRecorder* StepRecorder::activeRecorder = NULL;
+
+uint32_t StepRecorder::timestamp()
+{
+#ifdef ARDUINO
+    return ARM_DWT_CYCCNT;
+#else
+    return (uint32_t)(uint64_t)(hostClock.now() * 1000);
+#endif
+}
+
+uint32_t StepRecorder::cycleCount()
+{
+#ifdef ARDUINO
+    return ARM_DWT_CYCCNT;
+#else
+    return (uint32_t)(uint64_t)(hostClock.realTime() * 1000);
+#endif
+}
+
+double StepRecorder::ticksPerMicrosecond()
+{
+#ifdef ARDUINO
+    return F_CPU_ACTUAL / 1000000.0;
+#else
+    return 1000.0;
+#endif
+}
+
+void StepRecorder::record(uint8_t axisMask, float interval)
+{
+    StepRecorder* recorder = activeRecorder;
+    if (recorder == NULL)
+        return;
+    if (recorder->edgeCount >= BENCHMARK_MAX_STEP_EDGES) {
+        recorder->droppedEdges++;
+        return;
+    }
+    StepEdge* edge = &recorder->edges[recorder->edgeCount];
+    edge->time = timestamp();
+    edge->interval = interval;
+    edge->axisMask = axisMask;
+    recorder->edgeCount++;
+}
+
+void StepRecorder::start()
+{
+    noInterrupts();
+    this->edgeCount = 0;
+    this->droppedEdges = 0;
+    activeRecorder = this;
+    interrupts();
+}
+
+void StepRecorder::stop()
+{
+    noInterrupts();
+    if (activeRecorder == this)
+        activeRecorder = NULL;
+    interrupts();
+}
+
+StepEdge* StepRecorder::getEdges()
+{
+    return this->edges;
+}
+
+uint32_t StepRecorder::getEdgeCount()
+{
+    return this->edgeCount;
+}
+
+uint32_t StepRecorder::getDroppedEdges()
+{
+    return this->droppedEdges;
+}
@@ -20,9 +20,42 @@ Stepper::Stepper(
     double gearReduction,
     int32_t maxPosition,
     bool reverseDir,
-    int32_t encoderThreshole,
+    int32_t encoderThreshold,
     int axis,
     bool enableCrashDetection)
+    : Stepper(
+        stepPin,
+        dirPin,
+        limPin,
+        encoder,
+        microsteping,
+        gearReduction,
+        maxPosition,
+        reverseDir,
+        encoderThreshold,
+        axis,
+        enableCrashDetection,
+        degreesPerStep(microsteping, gearReduction),
+        encoderRatioNumerator(microsteping),
+        encoderRatioDenominator(microsteping))
+{
+}
+
+Stepper::Stepper(
+    uint8_t stepPin,
+    uint8_t dirPin,
+    uint8_t limPin,
+    Encoder* encoder,
+    int32_t microsteping,
+    double gearReduction,
+    int32_t maxPosition,
+    bool reverseDir,
+    int32_t encoderThreshold,
+    int axis,
+    bool enableCrashDetection,
+    double degreeChangePerStep,
+    int32_t encoderStepsNumerator,
+    int32_t encoderStepsDenominator)
 {
     this->stepPin = stepPin;
     this->dirPin = dirPin;
@@ -32,9 +65,11 @@ Stepper::Stepper(
     this->maxMotorPosition = maxPosition;
     this->invertMotorDirection = reverseDir;
     this->encoderThreshold = encoderThreshold;
-    this->degreeChangePerStep = DEGREES_PER_ROTATION / (microsteping * gearReduction);
+    this->degreeChangePerStep = degreeChangePerStep;
     this->encoder = encoder;
     this->disable = false;
+    this->encoderStepsNumerator = encoderStepsNumerator;
+    this->encoderStepsDenominator = encoderStepsDenominator;
     this->axis = axis;
     this->enableCrashDetection = enableCrashDetection;
 
@@ -48,65 +83,107 @@ Stepper::Stepper(
 
 bool Stepper::pulse()
 {
-    if (digitalReadFast(this->limPin) && this->counterClockwise)
-        if (limitSwitchFilter(this->limPin, 20, 0.75))
+    if (!takeStep())
+        return false;
+    if (!this->disable) {
+        digitalWrite(this->stepPin, HIGH);
+        delayMicroseconds(STEP_PULSE_MICROSECONDS);
+        digitalWrite(this->stepPin, LOW);
+    }
+    return true;
+}
+
+bool Stepper::takeStep()
+{
+    if (this->counterClockwise) {
+        if (this->limitSwitches != NULL) {
+            if (this->limitSwitches->isPressed(this->axis))
+                return false;
+        } else if (digitalReadFast(this->limPin) && limitSwitchFilter(this->limPin, 20, 0.75)) {
             return false;
+        }
+    }
     if (this->counterClockwise) {
         if (!setCurrentPosition(getCurrentPositionSteps() - 1))
             return false;
     } else if (!setCurrentPosition(getCurrentPositionSteps() + 1)) {
         return false;
     }
-    if (!this->disable) {
-        digitalWrite(this->stepPin, HIGH);
-        delayMicroseconds(3);
-        digitalWrite(this->stepPin, LOW);
-    }
     return true;
 }
 
 bool Stepper::comparePositionToEncoder()
+{
+    return comparePositionToEncoder(readEncoderPosition());
+}
+
+bool Stepper::comparePositionToEncoder(int32_t encoderSteps)
 {
     if (enableCrashDetection) {
-        long value = abs(readEncoderPosition() - (int32_t)this->currentPosition);
-        if (value > 300) {
-            Serial.print("Difference: ");
-            Serial.print(value);
-            Serial.print(", ");
-            Serial.println(200);
+        long value = abs(encoderSteps - (int32_t)this->currentPosition);
+        if (value > 300)
             return false;
-        }
     }
     return true;
 }
 
 int32_t Stepper::readEncoderPosition()
 {
-    return (int32_t)(this->encoder->read() * (this->microsteping / ENCODER_CPR));
+    return encoderCountsToSteps(this->encoder->read());
 }
 
 int32_t Stepper::resetEncoderPosition()
 {
-    return (int32_t)(this->encoder->readAndReset() * (this->microsteping / ENCODER_CPR));
+    return encoderCountsToSteps(this->encoder->readAndReset());
+}
+
+int32_t Stepper::encoderCountsToSteps(int32_t counts)
+{
+    return (int32_t)((int64_t)counts * this->encoderStepsNumerator / this->encoderStepsDenominator);
+}
+
+Encoder* Stepper::getEncoder()
+{
+    return this->encoder;
 }
 
 bool Stepper::readLimitSwitch()
 {
+    if (this->limitSwitches != NULL)
+        return this->limitSwitches->isPressed(this->axis);
     return limitSwitchFilter(this->limPin, 20, 0.6);
 }
 
+void Stepper::setLimitSwitchSampler(LimitSwitchSampler* limitSwitches)
+{
+    this->limitSwitches = limitSwitches;
+}
+
 bool Stepper::getDirection()
 {
     return this->counterClockwise;
 }
 
-void Stepper::setDirection(bool counterClockwise)
+void Stepper::setDirection(bool counterClockwise, bool writePin)
 {
     this->counterClockwise = counterClockwise;
-    if ((counterClockwise && this->invertMotorDirection) || (!counterClockwise && !this->invertMotorDirection))
-        digitalWrite(this->dirPin, LOW);
-    else
-        digitalWrite(this->dirPin, HIGH);
+    if (writePin)
+        digitalWrite(this->dirPin, getDirectionPinLevel() ? HIGH : LOW);
+}
+
+bool Stepper::getDirectionPinLevel()
+{
+    return this->counterClockwise != this->invertMotorDirection;
+}
+
+uint8_t Stepper::getStepPin()
+{
+    return this->stepPin;
+}
+
+uint8_t Stepper::getDirPin()
+{
+    return this->dirPin;
 }
 
 int32_t Stepper::getCurrentPositionSteps()
@@ -156,6 +233,27 @@ bool Stepper::isCrashDetectionEnabled() {
     return this->enableCrashDetection;
 }
 
+void Stepper::setCrashDetection(bool enable)
+{
+    this->enableCrashDetection = enable;
+}
+
+void Stepper::setMotionLimits(double maxVelocity, double maxAcceleration)
+{
+    this->maxVelocity = maxVelocity;
+    this->maxAcceleration = maxAcceleration;
+}
+
+double Stepper::getMaxVelocity()
+{
+    return this->maxVelocity;
+}
+
+double Stepper::getMaxAcceleration()
+{
+    return this->maxAcceleration;
+}
+
 String Stepper::toString()
 {
     String motorString = "Motor Info: Pins[ ";
@@ -177,4 +275,27 @@ String Stepper::toString()
         motorString = String(motorString + "CLKWS ]");
     }
     return motorString;
-}
\ No newline at end of file
+}
+
+void readEncoderSnapshot(Stepper* motors, EncoderSnapshot* snapshot)
+{
+    volatile int32_t* counts[DOF];
+    for (int i = 0; i < DOF; i++) {
+        counts[i] = getEncoderCount(motors[i].getEncoder(), configEncoderPins[i]);
+    }
+    // Only the loads are done with interrupts off, so no encoder interrupt can land between two axes
+    __disable_irq();
+    snapshot->counts[0] = *counts[0];
+    snapshot->counts[1] = *counts[1];
+    snapshot->counts[2] = *counts[2];
+    snapshot->counts[3] = *counts[3];
+    snapshot->counts[4] = *counts[4];
+    snapshot->counts[5] = *counts[5];
+    __enable_irq();
+    snapshot->timeStamp = micros();
+    // The ratio of each axis is a constant, so the scaling needs no division at runtime
+    forEachAxis<DOF>([&](auto axis) {
+        typedef AxisConfig<decltype(axis)::value> Config;
+        snapshot->steps[Config::axis] = (int32_t)((int64_t)snapshot->counts[Config::axis] * Config::stepsNumerator / Config::stepsDenominator);
+    });
+}
@@ -0,0 +1,175 @@
+/**
+ * This file is associated with Telemetry.h. It packs the state of the arm into telemetry frames
+ * and writes them to the serial port without waiting on it.
+ *
+ * @author Thomas Batchelder
+ * @file Telemetry.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#include "../include/Telemetry.h"
+#include "../include/Communication.h"
+
+Telemetry::Telemetry(Stepper* motors, EventQueue* eventQueue, Communication* communication)
+{
+    this->motors = motors;
+    this->eventQueue = eventQueue;
+    this->communication = communication;
+    this->sequence = 0;
+    this->hasLooped = false;
+    this->loops = 0;
+    this->longestLoop = 0;
+    this->streamUnderruns = eventQueue->getStreamUnderruns();
+    this->frameErrors = communication->getFrameErrors();
+    this->rejectedEvents = eventQueue->getRejectedEvents();
+    this->framesDropped = false;
+    this->reportedRecoveries = 0;
+    setRate(TELEMETRY_RATE);
+}
+
+void Telemetry::update()
+{
+    uint32_t now = micros();
+    if (this->hasLooped) {
+        this->loops++;
+        this->longestLoop = max(this->longestLoop, now - this->loopTime);
+    }
+    this->loopTime = now;
+    this->hasLooped = true;
+
+    if (this->period != 0 && now - this->frameTime >= this->period) {
+        // Frames are due on a fixed schedule, a frame that is late does not move the ones after it
+        this->frameTime += this->period;
+        if (now - this->frameTime >= this->period)
+            this->frameTime = now;
+        queueFrame();
+    }
+    if (this->eventQueue->getLastCrashRecovery()->count != this->reportedRecoveries)
+        queueCrashRecovery();
+    sendFrames();
+}
+
+void Telemetry::setRate(uint32_t rate)
+{
+    rate = min(rate, (uint32_t)TELEMETRY_MAX_RATE);
+    this->period = rate == 0 ? 0 : (uint32_t)(SECONDS_TO_MICROSECONDS / rate);
+    this->frameTime = micros();
+}
+
+void Telemetry::queueFrame()
+{
+    EncoderSnapshot snapshot;
+    readEncoderSnapshot(this->motors, &snapshot);
+    int32_t motorSteps[DOF], followingError[DOF];
+    uint8_t flags = 0;
+    for (int i = 0; i < DOF; i++) {
+        motorSteps[i] = this->motors[i].getCurrentPositionSteps();
+        followingError[i] = motorSteps[i] - snapshot.steps[i];
+        if (i < DOF_ACTIVE && !this->motors[i].comparePositionToEncoder(snapshot.steps[i]))
+            flags |= TELEMETRY_FOLLOWING_ERROR;
+    }
+    if (this->eventQueue->isRecoveringFromCrash())
+        flags |= TELEMETRY_CRASH_RECOVERY;
+    uint32_t streamUnderruns = this->eventQueue->getStreamUnderruns();
+    uint32_t frameErrors = this->communication->getFrameErrors();
+    uint32_t rejectedEvents = this->eventQueue->getRejectedEvents();
+    // The counts can also go down when the queue statistics are reset, which is not an error
+    if (streamUnderruns > this->streamUnderruns)
+        flags |= TELEMETRY_STREAM_UNDERRUN;
+    if (frameErrors > this->frameErrors)
+        flags |= TELEMETRY_FRAME_ERROR;
+    if (rejectedEvents > this->rejectedEvents)
+        flags |= TELEMETRY_EVENT_REJECTED;
+    if (this->framesDropped)
+        flags |= TELEMETRY_FRAMES_DROPPED;
+    uint16_t queueDepth = this->eventQueue->getQueueSize();
+    uint16_t bufferedSetpoints = this->eventQueue->getBufferedSetpoints();
+    uint16_t loops = min(this->loops, (uint32_t)0xFFFF);
+
+    uint8_t frame[TELEMETRY_FRAME_SIZE + FRAME_CRC_SIZE];
+    uint32_t length = 0;
+    auto pack = [&](const void* value, uint32_t size) {
+        memcpy(frame + length, value, size);
+        length += size;
+    };
+    uint8_t type = FRAME_TELEMETRY;
+    pack(&type, sizeof(type));
+    pack(&this->sequence, sizeof(this->sequence));
+    pack(&snapshot.timeStamp, sizeof(snapshot.timeStamp));
+    pack(motorSteps, sizeof(motorSteps));
+    pack(snapshot.steps, sizeof(snapshot.steps));
+    pack(followingError, sizeof(followingError));
+    pack(&queueDepth, sizeof(queueDepth));
+    pack(&bufferedSetpoints, sizeof(bufferedSetpoints));
+    pack(&loops, sizeof(loops));
+    pack(&this->longestLoop, sizeof(this->longestLoop));
+    pack(&flags, sizeof(flags));
+    if (!addFrame(frame, length)) {
+        // The computer is not reading fast enough, the newest frame is dropped so the loop never waits
+        this->framesDropped = true;
+        this->sequence++;
+        return;
+    }
+
+    this->sequence++;
+    this->loops = 0;
+    this->longestLoop = 0;
+    this->streamUnderruns = streamUnderruns;
+    this->frameErrors = frameErrors;
+    this->rejectedEvents = rejectedEvents;
+    this->framesDropped = false;
+}
+
+void Telemetry::queueCrashRecovery()
+{
+    CrashRecovery* recovery = this->eventQueue->getLastCrashRecovery();
+    float velocity = recovery->velocity;
+
+    uint8_t frame[TELEMETRY_RECOVERY_SIZE + FRAME_CRC_SIZE];
+    uint32_t length = 0;
+    auto pack = [&](const void* value, uint32_t size) {
+        memcpy(frame + length, value, size);
+        length += size;
+    };
+    uint8_t type = FRAME_CRASH_RECOVERY;
+    pack(&type, sizeof(type));
+    pack(&recovery->count, sizeof(recovery->count));
+    pack(&recovery->axis, sizeof(recovery->axis));
+    pack(&recovery->motorSteps, sizeof(recovery->motorSteps));
+    pack(&recovery->encoderSteps, sizeof(recovery->encoderSteps));
+    pack(&recovery->detectedTime, sizeof(recovery->detectedTime));
+    pack(&recovery->decelerationTime, sizeof(recovery->decelerationTime));
+    pack(&recovery->settleTime, sizeof(recovery->settleTime));
+    pack(&velocity, sizeof(velocity));
+    if (addFrame(frame, length))
+        this->reportedRecoveries = recovery->count;
+}
+
+bool Telemetry::addFrame(uint8_t* frame, uint32_t length)
+{
+    // The frame is stored after its length, between two delimiters so it can be found among the text lines
+    uint8_t encoded[TELEMETRY_ENCODED_SIZE];
+    uint32_t encodedLength = encodeFrame(frame, length, encoded);
+    if (this->transmit.reserve(encodedLength) == NULL)
+        return false;
+    *this->transmit.reserve(0) = encodedLength;
+    for (uint32_t i = 0; i < encodedLength; i++)
+        *this->transmit.reserve(i + 1) = encoded[i];
+    this->transmit.commit(encodedLength + 1);
+    return true;
+}
+
+void Telemetry::sendFrames()
+{
+    uint8_t* length;
+    // A frame is only written whole, so the text lines written between loops never end up inside it
+    while ((length = this->transmit.front()) != NULL && Serial.availableForWrite() >= *length) {
+        uint8_t encoded[TELEMETRY_ENCODED_SIZE];
+        uint32_t encodedLength = *length;
+        for (uint32_t i = 0; i < encodedLength; i++)
+            encoded[i] = *this->transmit.at(i + 1);
+        for (uint32_t i = 0; i <= encodedLength; i++)
+            this->transmit.pop();
+        Serial.write(encoded, encodedLength);
+    }
+}
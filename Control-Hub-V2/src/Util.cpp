@@ -29,7 +29,7 @@ bool limitSwitchFilter(int limPin, int iterations, double threshold)
     for (int i = 0; i < iterations; i++) {
         count += digitalReadFast(limPin);
     }
-    return (count / iterations) > threshold;
+    return ((double)count / iterations) > threshold;
 }
 
 void testEncoderPosition(Encoder* encoders)
@@ -0,0 +1,336 @@
+/**
+ * This file is associated with HostArduino.h. It contains the stand-ins for the Arduino API used
+ * when the motion core is built on a computer.
+ *
+ * @author Thomas Batchelder
+ * @file HostArduino.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#ifndef ARDUINO
+
+#include "../../include/Hal.h"
+#include <chrono>
+#include <stdio.h>
+#include <sys/select.h>
+#include <thread>
+#include <unistd.h>
+
+/** Maximum number of virtual encoders that can follow a motor */
+#define HOST_MAX_ENCODERS 8
+
+HostClock hostClock;
+HostGpioPort hostGpioPorts[HOST_GPIO_PORTS];
+HostSerial Serial;
+
+/** Virtual encoders that follow the step pin of a motor */
+static Encoder* followingEncoders[HOST_MAX_ENCODERS] = { NULL };
+
+// +---------------------------------------------------+ //
+// |               --- Virtual Clock ---               | //
+// +---------------------------------------------------+ //
+
+double HostClock::realTime()
+{
+    static std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+double HostClock::now()
+{
+    if (!this->manual && !this->inInterrupt)
+        this->currentTime = max(this->currentTime, realTime());
+    return this->currentTime;
+}
+
+void HostClock::setManual(bool manual)
+{
+    now();
+    this->manual = manual;
+}
+
+void HostClock::advance(double microseconds)
+{
+    runTimers(this->currentTime + microseconds);
+}
+
+void HostClock::runTimers(double until)
+{
+    if (this->inInterrupt) {
+        this->currentTime = max(this->currentTime, until);
+        return;
+    }
+    while (true) {
+        IntervalTimer* nextTimer = NULL;
+        for (int i = 0; i < HOST_MAX_TIMERS; i++) {
+            if (this->timers[i] != NULL && this->timers[i]->getDeadline() <= until
+                && (nextTimer == NULL || this->timers[i]->getDeadline() < nextTimer->getDeadline()))
+                nextTimer = this->timers[i];
+        }
+        if (nextTimer == NULL)
+            break;
+        // A timer that is due while another callback is still running is run late, like a pending interrupt
+        this->currentTime = max(this->currentTime, nextTimer->getDeadline());
+        this->inInterrupt = true;
+        nextTimer->fire();
+        this->inInterrupt = false;
+    }
+    this->currentTime = max(this->currentTime, until);
+}
+
+void HostClock::update()
+{
+    if (!this->manual)
+        runTimers(realTime());
+}
+
+bool HostClock::isInInterrupt()
+{
+    return this->inInterrupt;
+}
+
+bool HostClock::addTimer(IntervalTimer* timer)
+{
+    int freeSlot = -1;
+    for (int i = 0; i < HOST_MAX_TIMERS; i++) {
+        if (this->timers[i] == timer)
+            return true;
+        if (this->timers[i] == NULL && freeSlot == -1)
+            freeSlot = i;
+    }
+    if (freeSlot == -1)
+        return false;
+    this->timers[freeSlot] = timer;
+    return true;
+}
+
+void HostClock::removeTimer(IntervalTimer* timer)
+{
+    for (int i = 0; i < HOST_MAX_TIMERS; i++) {
+        if (this->timers[i] == timer)
+            this->timers[i] = NULL;
+    }
+}
+
+void HostClock::wait(double microseconds)
+{
+    if (this->inInterrupt || this->manual) {
+        runTimers(this->currentTime + microseconds);
+        return;
+    }
+    double endTime = realTime() + microseconds;
+    if (microseconds >= 1000)
+        std::this_thread::sleep_for(std::chrono::microseconds((long)microseconds));
+    while (realTime() < endTime) { }
+    update();
+}
+
+uint32_t micros()
+{
+    return (uint32_t)(uint64_t)hostClock.now();
+}
+
+uint32_t millis()
+{
+    return (uint32_t)(uint64_t)(hostClock.now() / 1000);
+}
+
+void delay(uint32_t milliseconds)
+{
+    hostClock.wait(milliseconds * 1000.0);
+}
+
+void delayMicroseconds(uint32_t microseconds)
+{
+    hostClock.wait(microseconds);
+}
+
+// +---------------------------------------------------+ //
+// |                 --- Mock GPIO ---                 | //
+// +---------------------------------------------------+ //
+
+void hostAttachEncoder(Encoder* encoder)
+{
+    for (int i = 0; i < HOST_MAX_ENCODERS; i++) {
+        if (followingEncoders[i] == encoder)
+            return;
+    }
+    for (int i = 0; i < HOST_MAX_ENCODERS; i++) {
+        if (followingEncoders[i] == NULL) {
+            followingEncoders[i] = encoder;
+            return;
+        }
+    }
+}
+
+void hostDetachEncoder(Encoder* encoder)
+{
+    for (int i = 0; i < HOST_MAX_ENCODERS; i++) {
+        if (followingEncoders[i] == encoder)
+            followingEncoders[i] = NULL;
+    }
+}
+
+HostGpioPort* hostPinPort(uint8_t pin)
+{
+    return &hostGpioPorts[(pin / 32) % HOST_GPIO_PORTS];
+}
+
+void hostGpioSet(HostGpioPort* port, uint32_t mask)
+{
+    uint32_t rising = mask & ~port->state;
+    port->state |= mask;
+    port->setCount++;
+    if (rising == 0)
+        return;
+    // Virtual encoders count every rising edge on the step pin of the motor they follow
+    for (int i = 0; i < HOST_MAX_ENCODERS; i++) {
+        Encoder* encoder = followingEncoders[i];
+        if (encoder == NULL || encoder->getStepPin() < 0)
+            continue;
+        uint8_t stepPin = encoder->getStepPin();
+        if (hostPinPort(stepPin) == port && (rising & (1ul << (stepPin % 32))))
+            encoder->onStep(digitalRead(encoder->getDirPin()));
+    }
+}
+
+void hostGpioClear(HostGpioPort* port, uint32_t mask)
+{
+    port->state &= ~mask;
+    port->clearCount++;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) { }
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (value)
+        hostGpioSet(hostPinPort(pin), 1ul << (pin % 32));
+    else
+        hostGpioClear(hostPinPort(pin), 1ul << (pin % 32));
+}
+
+int digitalRead(uint8_t pin)
+{
+    return (hostPinPort(pin)->state >> (pin % 32)) & 1;
+}
+
+int digitalReadFast(uint8_t pin)
+{
+    return digitalRead(pin);
+}
+
+// +---------------------------------------------------+ //
+// |                   --- String ---                  | //
+// +---------------------------------------------------+ //
+
+String::String(double value, unsigned char decimalPlaces)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+    this->text = buffer;
+}
+
+String& String::operator+=(const String& other)
+{
+    this->text += other.text;
+    return *this;
+}
+
+String operator+(const String& a, const String& b)
+{
+    return String(a.text + b.text);
+}
+
+String operator+(const String& a, const char* b)
+{
+    return String(a.text + b);
+}
+
+// +---------------------------------------------------+ //
+// |               --- Virtual Serial ---              | //
+// +---------------------------------------------------+ //
+
+int HostSerial::available()
+{
+    if (this->stdio && this->stdinOpen)
+        readStdin();
+    return this->input.size() - this->readIndex;
+}
+
+int HostSerial::read()
+{
+    if (available() == 0)
+        return -1;
+    return (uint8_t)this->input[this->readIndex++];
+}
+
+size_t HostSerial::readBytes(char* buffer, size_t length)
+{
+    size_t count = min(length, (size_t)available());
+    memcpy(buffer, this->input.data() + this->readIndex, count);
+    this->readIndex += count;
+    return count;
+}
+
+int HostSerial::availableForWrite()
+{
+    return 4096;
+}
+
+size_t HostSerial::write(uint8_t value)
+{
+    return write(&value, 1);
+}
+
+size_t HostSerial::write(const uint8_t* buffer, size_t length)
+{
+    if (this->stdio) {
+        // The computer reads the pipe as the bytes are written, like the USB serial port
+        fwrite(buffer, 1, length, stdout);
+        fflush(stdout);
+        return length;
+    }
+    this->output.append((const char*)buffer, length);
+    if (this->echo)
+        fwrite(buffer, 1, length, stdout);
+    return length;
+}
+
+size_t HostSerial::print(const char* text)
+{
+    return write((const uint8_t*)text, strlen(text));
+}
+
+void HostSerial::inject(const uint8_t* data, size_t length)
+{
+    // Dropping bytes that have already been read before adding more
+    this->input.erase(0, this->readIndex);
+    this->readIndex = 0;
+    this->input.append((const char*)data, length);
+}
+
+void HostSerial::readStdin()
+{
+    fd_set inputs;
+    FD_ZERO(&inputs);
+    FD_SET(STDIN_FILENO, &inputs);
+    timeval timeout = { 0, 0 };
+    if (select(STDIN_FILENO + 1, &inputs, NULL, NULL, &timeout) <= 0)
+        return;
+    uint8_t buffer[4096];
+    ssize_t length = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+    if (length <= 0)
+        this->stdinOpen = false;
+    else
+        inject(buffer, length);
+}
+
+std::string HostSerial::takeOutput()
+{
+    std::string temp;
+    temp.swap(this->output);
+    return temp;
+}
+
+#endif
@@ -0,0 +1,49 @@
+/**
+ * This file is associated with HostEncoder.h. It contains the virtual encoder used when the
+ * motion core is built on a computer.
+ *
+ * @author Thomas Batchelder
+ * @file HostEncoder.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#ifndef ARDUINO
+
+#include "../../include/Hal.h"
+
+Encoder::~Encoder()
+{
+    hostDetachEncoder(this);
+}
+
+int32_t Encoder::readAndReset()
+{
+    int32_t temp = this->position;
+    write(0);
+    return temp;
+}
+
+void Encoder::write(int32_t position)
+{
+    this->position = position;
+    this->positionOffset = position;
+    this->stepCount = 0;
+}
+
+void Encoder::followStepper(uint8_t stepPin, uint8_t dirPin, bool countUpLevel, int32_t countsPerRevolution, int32_t stepsPerRevolution)
+{
+    this->stepPin = stepPin;
+    this->dirPin = dirPin;
+    this->countUpLevel = countUpLevel;
+    this->countsPerRevolution = countsPerRevolution;
+    this->stepsPerRevolution = stepsPerRevolution;
+    hostAttachEncoder(this);
+}
+
+void Encoder::onStep(bool dirLevel)
+{
+    this->stepCount += (dirLevel == this->countUpLevel) ? 1 : -1;
+    this->position = this->positionOffset + (int32_t)((int64_t)this->stepCount * this->countsPerRevolution / this->stepsPerRevolution);
+}
+
+#endif
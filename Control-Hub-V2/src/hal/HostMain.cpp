@@ -0,0 +1,24 @@
+/**
+ * This file contains the entry point used when the motion core is built on a computer. The Teensy
+ * core calls setup() and loop() on the microcontroller, on a computer this file does the same.
+ *
+ * @author Thomas Batchelder
+ * @file HostMain.cpp
+ * @date 10/17/2026 - File created
+ */
+
+// The unit tests (see test/) have an entry point of their own
+#if !defined(ARDUINO) && !defined(PIO_UNIT_TESTING)
+
+void setup();
+void loop();
+
+int main()
+{
+    setup();
+    while (true) {
+        loop();
+    }
+}
+
+#endif
@@ -0,0 +1,35 @@
+/**
+ * This file is associated with HostTimer.h. It contains the stand-in for the Teensy IntervalTimer
+ * used when the motion core is built on a computer.
+ *
+ * @author Thomas Batchelder
+ * @file HostTimer.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#ifndef ARDUINO
+
+#include "../../include/Hal.h"
+
+bool IntervalTimer::begin(void (*funct)(), double microseconds)
+{
+    this->callback = funct;
+    this->period = microseconds;
+    this->deadline = hostClock.now() + microseconds;
+    return hostClock.addTimer(this);
+}
+
+void IntervalTimer::end()
+{
+    hostClock.removeTimer(this);
+    this->callback = NULL;
+}
+
+void IntervalTimer::fire()
+{
+    this->deadline += this->period;
+    if (this->callback != NULL)
+        this->callback();
+}
+
+#endif
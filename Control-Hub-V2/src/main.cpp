@@ -1,5 +1,9 @@
+#include "../include/Benchmark.h"
 #include "../include/Calibration.h"
-#include <Arduino.h>
+#include "../include/Hal.h"
+
+// The unit tests (see test/) are built with the rest of src and run their own arm
+#ifndef PIO_UNIT_TESTING
 
 Controller controller;
 int limitSwitchPins[DOF] = LIMIT_SWITCH_PINS;
@@ -11,7 +15,25 @@ double pos2[DOF] = { 190, 45, 140, 167, 75, 170 };
 void setup()
 {
     Serial.begin(BAUDRATE);
+#ifdef HOST_SERIAL_BRIDGE
+    // The serial port is the pipe Controller.py talks to the arm through (see HostSerial::setStdio())
+    Serial.setStdio(true);
+#endif
+#ifdef ARDUINO
     delay(STARTUP_DELAY);
+#endif
+#ifdef RUN_BENCHMARKS
+    runBenchmarks(&controller);
+#ifndef ARDUINO
+    exit(0);
+#endif
+    return;
+#endif
+#ifdef HOST_SERIAL_BRIDGE
+    // There are no limit switches to home on, the arm starts from its zero position
+    hostClock.setManual(true);
+    return;
+#endif
     Serial.println("\n--- Initialization STARTING ---");
     //limitSwitchCalibration(&controller);
     home(&controller);
@@ -26,8 +48,8 @@ void loop()
         String input = Serial.readString();
         if (input.compareTo("1\n") == 0) {
             Serial.println("Command Received! 1");
-            controller.traverseStraightLine(pos1, HOMING_VELOCITY * 6, HOMING_ACCELERATION * 6, 0, 0, false, false);
-            controller.traverseStraightLine(pos2, HOMING_VELOCITY * 6, HOMING_ACCELERATION * 6, 0, 0, false, false);
+            controller.traverseStraightLine(pos1, HOMING_VELOCITY * 6, HOMING_ACCELERATION * 6, false, false);
+            controller.traverseStraightLine(pos2, HOMING_VELOCITY * 6, HOMING_ACCELERATION * 6, false, false);
         } else if (input.compareTo("2\n") == 0) {
             Serial.println("Command Received! 2");
             while (controller.isActive()) {
@@ -41,8 +63,19 @@ void loop()
     }
     */
     controller.update();
-    //controller.traverseStraightLine(pos1, HOMING_VELOCITY * 10, HOMING_ACCELERATION*5, 0, 0, false, true);
-    //controller.traverseStraightLine(pos2, HOMING_VELOCITY * 10, HOMING_ACCELERATION*5, 0, 0, false, true);
+#ifdef HOST_SERIAL_BRIDGE
+    // Each loop is given a fixed cost on the virtual clock, which is held back to real time. A loop held up by
+    // the computer is made up by the loops after it, the Teensy is never held up by another program.
+    hostClock.advance(HOST_BRIDGE_LOOP_MICROSECONDS);
+    while (hostClock.now() > hostClock.realTime()) { }
+    // The program ends once Controller.py has closed the pipe and every event has been completed
+    if (!Serial.isStdinOpen() && !controller.isActive())
+        exit(0);
+#endif
+    //controller.traverseStraightLine(pos1, HOMING_VELOCITY * 10, HOMING_ACCELERATION*5, false, true);
+    //controller.traverseStraightLine(pos2, HOMING_VELOCITY * 10, HOMING_ACCELERATION*5, false, true);
     //testLimitSwitchs(10000, 10, limitSwitchPins);
     //testEncoderPosition(controller.getEncoders());
-}
\ No newline at end of file
+}
+
+#endif
@@ -0,0 +1,101 @@
+"""
+Runs Controller.py against the motion core built for the computer, instead of the Teensy. The
+program built with [env:native_bridge] (or [env:native_bench_bridge]) reads the serial port from
+stdin and writes it to stdout, so Controller.py is given a port that is a pipe to that program.
+The port can damage the frames written to it and split them up with delays, like a bad USB link.
+
+@author Thomas Batchelder
+@file bridge.py
+@date 10/17/2026 - File created
+"""
+
+import importlib
+import os
+import random
+import subprocess
+import sys
+import threading
+import types
+from time import sleep
+
+PROJECT = os.path.abspath(os.path.join(os.path.dirname(__file__), "..", ".."))
+BRIDGE_PROGRAM = os.path.join(PROJECT, ".pio", "build", "native_bridge", "program")
+BENCH_BRIDGE_PROGRAM = os.path.join(PROJECT, ".pio", "build", "native_bench_bridge", "program")
+
+class PipePort:
+    """
+    Stands in for serial.Serial. corruptRate is the chance that a write has one bit flipped, jitter
+    is the longest delay in seconds between the pieces a write is split into.
+    """
+
+    def __init__(self, program, corruptRate=0, jitter=0, seed=1):
+        self.process = subprocess.Popen([program], stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+        self.random = random.Random(seed)
+        self.corruptRate = corruptRate
+        self.jitter = jitter
+        self.received = b""
+        self.lock = threading.Lock()
+        self.writes = 0
+        self.corrupted = 0
+        threading.Thread(target=self.readOutput, daemon=True).start()
+
+    def readOutput(self):
+        while True:
+            data = self.process.stdout.read1(4096)
+            if not data:
+                break
+            with self.lock:
+                self.received += data
+
+    def inWaiting(self):
+        with self.lock:
+            return len(self.received)
+
+    def read(self, size):
+        with self.lock:
+            data, self.received = self.received[:size], self.received[size:]
+        return data
+
+    def write(self, data):
+        self.writes += 1
+        if self.random.random() < self.corruptRate:
+            data = bytearray(data)
+            data[self.random.randrange(len(data))] ^= 1 << self.random.randrange(8)
+            data = bytes(data)
+            self.corrupted += 1
+        try:
+            while data:
+                size = self.random.randint(1, len(data)) if self.jitter else len(data)
+                self.process.stdin.write(data[:size])
+                self.process.stdin.flush()
+                data = data[size:]
+                if self.jitter and data:
+                    sleep(self.random.uniform(0, self.jitter))
+        except BrokenPipeError:
+            # The benchmarks end the program once they have finished, frames sent after that are not needed
+            pass
+
+    def close(self, timeout=60):
+        # The program finishes the events it has been given before it exits
+        try:
+            self.process.stdin.close()
+        except BrokenPipeError:
+            pass
+        code = self.process.wait(timeout)
+        self.process.stdout.close()
+        return code
+
+def loadController(port):
+    """
+    Imports Controller.py with a serial module that gives it the port, so the functions of the
+    script use the link to the program. Each call gives a new module with a new link.
+    """
+    serial = types.ModuleType("serial")
+    serial.Serial = lambda *args, **kwargs: port
+    sys.modules["serial"] = serial
+    sys.path.insert(0, os.path.dirname(PROJECT))
+    try:
+        sys.modules.pop("Controller", None)
+        return importlib.import_module("Controller")
+    finally:
+        sys.path.pop(0)
@@ -0,0 +1,40 @@
+"""
+Runs the benchmarks of the program built with [env:native_bench_bridge] through runBenchmarks() in
+Controller.py, so the serial load benchmark decodes and answers real frames from the computer.
+
+@author Thomas Batchelder
+@file test_benchmarks.py
+@date 10/17/2026 - File created
+"""
+
+import json
+import unittest
+
+from bridge import BENCH_BRIDGE_PROGRAM, PipePort, loadController
+
+class BenchmarkTest(unittest.TestCase):
+
+    def testSerialLoad(self):
+        port = PipePort(BENCH_BRIDGE_PROGRAM)
+        controller = loadController(port)
+        results = []
+        # runBenchmarks() prints each result, so the results are kept instead
+        controller.print = lambda line: results.append(json.loads(line))
+        controller.runBenchmarks()
+        self.assertEqual(port.close(), 0)
+
+        self.assertEqual(controller.link.frameErrors, 0)
+        self.assertGreater(port.writes, 0)
+        loads = [result for result in results if result["benchmark"] == "serial_load"]
+        self.assertEqual(len(loads), len([result for result in results if result["benchmark"] == "serial_load_start"]))
+        self.assertGreater(len(loads), 0)
+        moveSteps = results[0]["move_steps"]
+        for result in loads:
+            # Every axis finished the move while the frames were being handled
+            self.assertEqual(result["steps"], bin(result["axis_mask"]).count("1") * moveSteps)
+            self.assertEqual(result["dropped_edges"], 0)
+            self.assertEqual(result["missed_deadlines"], 0)
+        self.assertEqual(results[-1]["benchmark"], "summary")
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,75 @@
+"""
+Sends movements through Controller.py to the program built with [env:native_bridge], over a link
+that damages frames and splits them up. Every movement has to be used once, whatever the link does.
+
+@author Thomas Batchelder
+@file test_link.py
+@date 10/17/2026 - File created
+"""
+
+import struct
+import unittest
+from time import sleep
+
+from bridge import BRIDGE_PROGRAM, PipePort, loadController
+
+MOVEMENTS = 100
+
+class LinkTest(unittest.TestCase):
+
+    def sendMovements(self, corruptRate, jitter):
+        port = PipePort(BRIDGE_PROGRAM, corruptRate, jitter)
+        controller = loadController(port)
+        link = controller.link
+        replies = {"accepted": 0, "rejected": 0, "status": None}
+        handleReply = link.handleReply
+        def countReply(data):
+            values = handleReply(data)
+            if values is not None and values[0] == controller.FRAME_ACK:
+                replies["accepted"] += values[2]
+                replies["rejected"] += values[3]
+            return values
+        def handleLine(line):
+            if line.startswith("Queue Status: "):
+                replies["status"] = [int(value) for value in line.split()[2:]]
+                return True
+            return False
+        link.handleReply = countReply
+        link.lineHandler = handleLine
+
+        link.send([controller.movementRecord([10] * 3 + [10 + (i % 2) * 0.5] + [10] * 2, 1.5e-3, 3e-10) for i in range(MOVEMENTS)])
+        link.flush()
+        # The request is sent whole, so the reply is not lost to a damaged frame
+        port.corruptRate = 0
+        link.send([struct.pack("<B", controller.QUEUE_STATUS_REQUEST)])
+        link.flush()
+        while replies["status"] is None:
+            link.pump()
+            sleep(0.001)
+        self.assertEqual(port.close(), 0)
+
+        self.assertEqual(replies["accepted"], MOVEMENTS)
+        self.assertEqual(replies["rejected"], 0)
+        self.assertEqual(link.frameErrors, 0)
+        status = replies["status"]
+        self.assertEqual(status[3], 0) # Rejected events
+        self.assertLessEqual(status[2], status[1]) # High water mark within the capacity
+        if port.corrupted > 0:
+            self.assertGreater(status[7], 0) # Frame errors
+        return port
+
+    def testCleanLink(self):
+        port = self.sendMovements(0, 0)
+        self.assertEqual(port.corrupted, 0)
+
+    def testCorruptedLink(self):
+        for corruptRate in (0.2, 0.5):
+            with self.subTest(corruptRate=corruptRate):
+                port = self.sendMovements(corruptRate, 0)
+                self.assertGreater(port.corrupted, 0)
+
+    def testJitteryLink(self):
+        self.sendMovements(0.2, 0.002)
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,60 @@
+"""
+Streams a trajectory in real time through Controller.py to the program built with
+[env:native_bridge], the playback delay has to cover the pipe so the stream never runs dry.
+
+@author Thomas Batchelder
+@file test_stream.py
+@date 10/17/2026 - File created
+"""
+
+import math
+import struct
+import unittest
+from time import sleep
+
+from bridge import BRIDGE_PROGRAM, PipePort, loadController
+
+STREAM_SECONDS = 2.0
+
+def trajectory(t):
+    if t > STREAM_SECONDS:
+        return None
+    return [10, 10, 10, 10 + 5 * math.sin(math.pi * t), 10 + 3 * (1 - math.cos(math.pi * t)), 10]
+
+class StreamTest(unittest.TestCase):
+
+    def testStreamWithoutUnderrun(self):
+        port = PipePort(BRIDGE_PROGRAM)
+        controller = loadController(port)
+        link = controller.link
+        status = []
+        def handleLine(line):
+            if line.startswith("Queue Status: "):
+                status.append([int(value) for value in line.split()[2:]])
+                return True
+            return False
+        link.lineHandler = handleLine
+
+        link.send([controller.movementRecord([10] * 6, 1.5e-3, 3e-10)])
+        link.flush()
+        # The setpoints are only kept once the stream has started, so the arm has to reach the start first
+        sleep(1.0)
+        controller.streamTrajectory(trajectory, 500, 20000, controller.STREAM_CUBIC)
+        # The movement after the stream starts from where the stream ended
+        link.send([controller.movementRecord([10] * 6, 1.5e-3, 3e-10)])
+        link.flush()
+        sleep(0.5)
+        link.send([struct.pack("<B", controller.QUEUE_STATUS_REQUEST)])
+        link.flush()
+        while not status:
+            link.pump()
+            sleep(0.001)
+        self.assertEqual(port.close(), 0)
+
+        self.assertEqual(link.frameErrors, 0)
+        self.assertEqual(status[0][3], 0) # Rejected events
+        self.assertEqual(status[0][8], 0) # Buffered setpoints, the whole stream was played
+        self.assertEqual(status[0][9], 0) # Stream underruns
+
+if __name__ == "__main__":
+    unittest.main()
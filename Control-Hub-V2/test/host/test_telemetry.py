@@ -0,0 +1,52 @@
+"""
+Watches the telemetry of the program built with [env:native_bridge] through Controller.py while
+the arm moves. The frames have to arrive at the rate asked for, in sequence and undamaged.
+
+@author Thomas Batchelder
+@file test_telemetry.py
+@date 10/17/2026 - File created
+"""
+
+import unittest
+from time import sleep, time
+
+from bridge import BRIDGE_PROGRAM, PipePort, loadController
+
+RATE = 200
+WATCH_SECONDS = 2.0
+
+class TelemetryTest(unittest.TestCase):
+
+    def testRateAndSequence(self):
+        port = PipePort(BRIDGE_PROGRAM)
+        controller = loadController(port)
+        link = controller.link
+        frames = []
+        decodeTelemetry = controller.decodeTelemetry
+        def keepFrame(data):
+            telemetry = decodeTelemetry(data)
+            if telemetry is not None:
+                frames.append(telemetry)
+            return telemetry
+        controller.decodeTelemetry = keepFrame
+
+        controller.setTelemetryRate(RATE)
+        link.send([controller.movementRecord([10] * 3 + [10 + (i % 2) * 4] + [10] * 2, 1.5e-3, 3e-10) for i in range(6)])
+        end = time() + WATCH_SECONDS
+        while time() < end:
+            link.pump()
+            sleep(0.0005)
+        link.flush()
+        self.assertEqual(port.close(), 0)
+
+        self.assertEqual(link.frameErrors, 0)
+        self.assertGreater(len(frames), RATE * WATCH_SECONDS / 2)
+        # The frame times are taken by the arm, so the rate does not depend on how fast the pipe is read
+        seconds = (frames[-1]["time"] - frames[0]["time"]) / 1e6
+        self.assertAlmostEqual((len(frames) - 1) / seconds, RATE, delta=RATE * 0.02)
+        for previous, frame in zip(frames, frames[1:]):
+            self.assertEqual((frame["sequence"] - previous["sequence"]) & 0xFFFF, 1)
+        self.assertNotIn("telemetry dropped", set(flag for frame in frames for flag in frame["flags"]))
+
+if __name__ == "__main__":
+    unittest.main()
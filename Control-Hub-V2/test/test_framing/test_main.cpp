@@ -0,0 +1,137 @@
+/**
+ * This file contains the tests of the CRC and the COBS encoding used to frame the data sent over
+ * the serial port (see Framing.h).
+ *
+ * @author Thomas Batchelder
+ * @file test_main.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#include <unity.h>
+#include "Framing.h"
+
+void setUp() { }
+void tearDown() { }
+
+/**
+ * This function is used to decode an encoded frame the way Communication does, one byte at a time
+ * @param encoded is the encoded frame without its delimiter
+ * @param length is the number of bytes in the encoded frame
+ * @param output is where the decoded frame is stored
+ * @return is the number of bytes in the decoded frame, or -1 if the frame was cut short
+ */
+int decodeAll(const uint8_t* encoded, size_t length, uint8_t* output)
+{
+    CobsDecoder decoder;
+    resetCobs(&decoder);
+    int decodedLength = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (decodeCobs(&decoder, encoded[i], &output[decodedLength]))
+            decodedLength++;
+    }
+    return isCobsComplete(&decoder) ? decodedLength : -1;
+}
+
+/**
+ * This function is used to encode a frame, decode it again and check it is unchanged
+ * @param data is the frame
+ * @param length is the number of bytes in the frame
+ */
+void checkRoundTrip(const uint8_t* data, size_t length)
+{
+    uint8_t encoded[1100], decoded[1100];
+    size_t encodedLength = encodeCobs(data, length, encoded);
+    TEST_ASSERT_LESS_OR_EQUAL(length + length / 254 + 1, encodedLength);
+    for (size_t i = 0; i < encodedLength; i++)
+        TEST_ASSERT_TRUE(encoded[i] != FRAME_DELIMITER);
+    TEST_ASSERT_EQUAL_INT(length, decodeAll(encoded, encodedLength, decoded));
+    TEST_ASSERT_EQUAL_MEMORY(data, decoded, length);
+}
+
+void test_crc_check_value()
+{
+    // The check value of CRC-16/CCITT-FALSE
+    const uint8_t data[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, calculateCrc16(data, sizeof(data)));
+    TEST_ASSERT_EQUAL_HEX16(FRAME_CRC_INITIAL, calculateCrc16(data, 0));
+
+    uint16_t crc = FRAME_CRC_INITIAL;
+    for (size_t i = 0; i < sizeof(data); i++)
+        crc = updateCrc16(crc, data[i]);
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, crc);
+}
+
+void test_cobs_known_encodings()
+{
+    const uint8_t zero[] = { 0x00 };
+    const uint8_t zeroEncoded[] = { 0x01, 0x01 };
+    const uint8_t mixed[] = { 0x11, 0x22, 0x00, 0x33 };
+    const uint8_t mixedEncoded[] = { 0x03, 0x11, 0x22, 0x02, 0x33 };
+    uint8_t encoded[8];
+    TEST_ASSERT_EQUAL_size_t(sizeof(zeroEncoded), encodeCobs(zero, sizeof(zero), encoded));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(zeroEncoded, encoded, sizeof(zeroEncoded));
+    TEST_ASSERT_EQUAL_size_t(sizeof(mixedEncoded), encodeCobs(mixed, sizeof(mixed), encoded));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(mixedEncoded, encoded, sizeof(mixedEncoded));
+    TEST_ASSERT_EQUAL_size_t(1, encodeCobs(mixed, 0, encoded));
+    TEST_ASSERT_EQUAL_HEX8(0x01, encoded[0]);
+}
+
+void test_cobs_round_trip()
+{
+    uint8_t data[1024];
+    // Runs of bytes without a zero either side of the longest block
+    const size_t lengths[] = { 1, 2, 253, 254, 255, 256, 508, 509, 1024 };
+    for (size_t length : lengths) {
+        for (size_t i = 0; i < length; i++)
+            data[i] = (uint8_t)(i % 255 + 1);
+        checkRoundTrip(data, length);
+    }
+    // Zeros at the start, the end and next to each other
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (i % 7 == 0 || i % 7 == 1) ? 0 : (uint8_t)i;
+    checkRoundTrip(data, sizeof(data));
+    memset(data, 0, sizeof(data));
+    checkRoundTrip(data, 300);
+}
+
+void test_cobs_cut_short()
+{
+    const uint8_t data[] = { 0x11, 0x22, 0x33, 0x00, 0x44 };
+    uint8_t encoded[8], decoded[8];
+    size_t encodedLength = encodeCobs(data, sizeof(data), encoded);
+    TEST_ASSERT_EQUAL_INT(-1, decodeAll(encoded, encodedLength - 1, decoded));
+    TEST_ASSERT_EQUAL_INT(-1, decodeAll(encoded, 2, decoded));
+}
+
+void test_encode_frame()
+{
+    uint8_t frame[300 + FRAME_CRC_SIZE];
+    const size_t lengths[] = { 1, 9, 251, 252, 253, 300 };
+    for (size_t length : lengths) {
+        for (size_t i = 0; i < length; i++)
+            frame[i] = (uint8_t)(i * 7);
+        frame[0] = FRAME_TELEMETRY;
+        uint16_t crc = calculateCrc16(frame, length);
+
+        uint8_t encoded[FRAME_ENCODED_SIZE(300)], decoded[300 + FRAME_CRC_SIZE];
+        size_t encodedLength = encodeFrame(frame, length, encoded);
+        TEST_ASSERT_LESS_OR_EQUAL(FRAME_ENCODED_SIZE(length), encodedLength);
+        TEST_ASSERT_EQUAL_HEX8(FRAME_DELIMITER, encoded[0]);
+        TEST_ASSERT_EQUAL_HEX8(FRAME_DELIMITER, encoded[encodedLength - 1]);
+        TEST_ASSERT_EQUAL_INT(length + FRAME_CRC_SIZE, decodeAll(encoded + 1, encodedLength - 2, decoded));
+        TEST_ASSERT_EQUAL_MEMORY(frame, decoded, length);
+        // The CRC follows the frame, little endian like the rest of the values
+        TEST_ASSERT_EQUAL_HEX16(crc, decoded[length] | (decoded[length + 1] << 8));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_crc_check_value);
+    RUN_TEST(test_cobs_known_encodings);
+    RUN_TEST(test_cobs_round_trip);
+    RUN_TEST(test_cobs_cut_short);
+    RUN_TEST(test_encode_frame);
+    return UNITY_END();
+}
@@ -0,0 +1,423 @@
+/**
+ * This file contains the tests of the link with the computer: the frames sent by the computer and
+ * the Ack, Nack and Credit replies to them (see Communication.h), and the telemetry and crash
+ * recovery frames (see Telemetry.h). The frames are written to the virtual serial port and the
+ * replies are decoded from what the arm writes, the same way Controller.py does.
+ *
+ * @author Thomas Batchelder
+ * @file test_main.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "Controller.h"
+
+/** Time the virtual clock moves for each main loop */
+#define TEST_LOOP_MICROSECONDS 20
+
+/** The arm keeps its sequence numbers and events from one test to the next */
+Controller* controller;
+/** Sequence number of the next frame sent to the arm */
+uint16_t sequence = 0;
+
+/** Frames written by the arm, decoded and checked, and the text lines written between them */
+struct Output {
+    std::vector<std::vector<uint8_t>> frames;
+    std::string text;
+    /** Number of frames that could not be decoded */
+    int damaged;
+};
+
+void setUp() { }
+void tearDown() { }
+
+/**
+ * This function is used to run the main loop for a while
+ * @param microseconds is the time the loop is run for
+ */
+void runFor(double microseconds)
+{
+    double endTime = hostClock.now() + microseconds;
+    while (hostClock.now() < endTime) {
+        controller->update();
+        hostClock.advance(TEST_LOOP_MICROSECONDS);
+    }
+}
+
+/**
+ * This function is used to run the main loop until every event is completed
+ */
+void runUntilIdle()
+{
+    while (controller->isActive()) {
+        controller->update();
+        hostClock.advance(TEST_LOOP_MICROSECONDS);
+    }
+}
+
+/**
+ * This function is used to send a frame to the arm
+ * @param frameSequence is the sequence number of the frame
+ * @param records is the records of the frame
+ * @param damagedByte is the byte of the encoded frame that has a bit flipped, -1 for none
+ */
+void sendFrame(uint16_t frameSequence, const std::vector<uint8_t>& records, int damagedByte = -1)
+{
+    std::vector<uint8_t> data(FRAME_SEQUENCE_SIZE);
+    memcpy(data.data(), &frameSequence, FRAME_SEQUENCE_SIZE);
+    data.insert(data.end(), records.begin(), records.end());
+    uint16_t crc = calculateCrc16(data.data(), data.size());
+    data.push_back(crc & 0xFF);
+    data.push_back(crc >> 8);
+    std::vector<uint8_t> encoded(data.size() + data.size() / 254 + 2);
+    encoded.resize(encodeCobs(data.data(), data.size(), encoded.data()));
+    if (damagedByte >= 0)
+        encoded[damagedByte] ^= 0x10;
+    encoded.push_back(FRAME_DELIMITER);
+    Serial.inject(encoded.data(), encoded.size());
+}
+
+/**
+ * This function is used to make a movement record
+ * @param target is the target of the first axis in degrees, the other axes go to 10 degrees
+ * @param jerk is the jerk of an S-curve profile, 0 for a trapezoid profile
+ * @return is the record
+ */
+std::vector<uint8_t> movementRecord(float target, float jerk = 0)
+{
+    float values[DOF + 3];
+    for (int i = 0; i < DOF; i++)
+        values[i] = 10;
+    values[0] = target;
+    values[DOF] = 0.5e-3f;
+    values[DOF + 1] = 1e-10f;
+    values[DOF + 2] = jerk;
+    std::vector<uint8_t> record(MOVEMENT_RECORD_SIZE);
+    record[0] = MOVEMENT_EVENT;
+    memcpy(&record[1], values, sizeof(values));
+    record[MOVEMENT_RECORD_SIZE - 1] = 0;
+    return record;
+}
+
+/**
+ * This function is used to make a record of a request that holds a uint16 value, or no value
+ * @param code is the code of the request
+ * @param value is the value, only used by TELEMETRY_RATE_REQUEST
+ * @return is the record
+ */
+std::vector<uint8_t> requestRecord(uint8_t code, uint16_t value = 0)
+{
+    std::vector<uint8_t> record(1, code);
+    if (code == TELEMETRY_RATE_REQUEST) {
+        record.push_back(value & 0xFF);
+        record.push_back(value >> 8);
+    }
+    return record;
+}
+
+/**
+ * This function is used to take what the arm has written, the frames sit between two delimiters
+ * which never appear in the text lines
+ * @return is the frames and the text
+ */
+Output takeOutput()
+{
+    Output output = {};
+    std::string written = Serial.takeOutput();
+    size_t index = 0;
+    while (index < written.size()) {
+        if (written[index] != FRAME_DELIMITER) {
+            output.text += written[index++];
+            continue;
+        }
+        size_t end = written.find((char)FRAME_DELIMITER, index + 1);
+        TEST_ASSERT_TRUE(end != std::string::npos);
+        if (end == index + 1) {
+            // The delimiter ended a frame that was already taken
+            index++;
+            continue;
+        }
+        CobsDecoder decoder;
+        resetCobs(&decoder);
+        std::vector<uint8_t> frame;
+        for (size_t i = index + 1; i < end; i++) {
+            uint8_t decoded;
+            if (decodeCobs(&decoder, written[i], &decoded))
+                frame.push_back(decoded);
+        }
+        index = end + 1;
+        if (!isCobsComplete(&decoder) || frame.size() < 1 + FRAME_CRC_SIZE
+            || calculateCrc16(frame.data(), frame.size() - FRAME_CRC_SIZE) != (frame[frame.size() - 2] | (frame[frame.size() - 1] << 8))) {
+            output.damaged++;
+            continue;
+        }
+        frame.resize(frame.size() - FRAME_CRC_SIZE);
+        output.frames.push_back(frame);
+    }
+    return output;
+}
+
+/**
+ * This function is used to read a uint16 value of a frame
+ * @param frame is the frame
+ * @param index is the index of the value, counted in uint16 values after the type
+ * @return is the value
+ */
+uint16_t replyValue(const std::vector<uint8_t>& frame, int index)
+{
+    uint16_t value;
+    memcpy(&value, &frame[1 + index * sizeof(uint16_t)], sizeof(value));
+    return value;
+}
+
+/**
+ * This function is used to check the only frame written is an Ack
+ * @param output is what the arm wrote
+ * @param ackSequence is the sequence number being answered
+ * @param accepted is the number of records used
+ * @param rejected is the number of records that were not valid
+ */
+void checkAck(const Output& output, uint16_t ackSequence, uint16_t accepted, uint16_t rejected)
+{
+    TEST_ASSERT_EQUAL_INT(0, output.damaged);
+    TEST_ASSERT_EQUAL_size_t(1, output.frames.size());
+    const std::vector<uint8_t>& frame = output.frames[0];
+    TEST_ASSERT_EQUAL_size_t(ACK_REPLY_SIZE, frame.size());
+    TEST_ASSERT_EQUAL_UINT8(FRAME_ACK, frame[0]);
+    TEST_ASSERT_EQUAL_UINT16(ackSequence, replyValue(frame, 0));
+    TEST_ASSERT_EQUAL_UINT16(accepted, replyValue(frame, 1));
+    TEST_ASSERT_EQUAL_UINT16(rejected, replyValue(frame, 2));
+    EventQueue* eventQueue = controller->getEventQueue();
+    TEST_ASSERT_EQUAL_UINT16(eventQueue->getQueueCapacity() - eventQueue->getQueueSize(), replyValue(frame, 3));
+}
+
+/**
+ * This function is used to check the only frame written is a Nack
+ * @param output is what the arm wrote
+ * @param expectedSequence is the sequence number the arm is waiting for
+ */
+void checkNack(const Output& output, uint16_t expectedSequence)
+{
+    TEST_ASSERT_EQUAL_INT(0, output.damaged);
+    TEST_ASSERT_EQUAL_size_t(1, output.frames.size());
+    const std::vector<uint8_t>& frame = output.frames[0];
+    TEST_ASSERT_EQUAL_size_t(NACK_REPLY_SIZE, frame.size());
+    TEST_ASSERT_EQUAL_UINT8(FRAME_NACK, frame[0]);
+    TEST_ASSERT_EQUAL_UINT16(expectedSequence, replyValue(frame, 0));
+}
+
+void test_frame_is_acked()
+{
+    std::vector<uint8_t> records = movementRecord(12);
+    std::vector<uint8_t> second = movementRecord(10);
+    records.insert(records.end(), second.begin(), second.end());
+    sendFrame(sequence, records);
+    controller->update();
+    checkAck(takeOutput(), sequence, 2, 0);
+    TEST_ASSERT_EQUAL_UINT32(2, controller->getEventQueue()->getQueueSize());
+    sequence++;
+    runUntilIdle();
+    takeOutput();
+}
+
+void test_invalid_record_is_rejected()
+{
+    // A movement with a negative jerk is rejected, the rest of the frame is still used
+    std::vector<uint8_t> records = movementRecord(12, -1);
+    std::vector<uint8_t> second = movementRecord(12);
+    records.insert(records.end(), second.begin(), second.end());
+    sendFrame(sequence, records);
+    controller->update();
+    checkAck(takeOutput(), sequence, 1, 1);
+    sequence++;
+    runUntilIdle();
+    takeOutput();
+}
+
+void test_damaged_frame_is_nacked()
+{
+    std::vector<uint8_t> records = movementRecord(14);
+    uint32_t frameErrors = controller->getCommunication()->getFrameErrors();
+    // Every byte of the frame is damaged in turn, none of the damaged frames may be used
+    size_t encodedLength = FRAME_SEQUENCE_SIZE + records.size() + FRAME_CRC_SIZE + 1;
+    for (size_t i = 0; i < encodedLength; i++) {
+        sendFrame(sequence, records, i);
+        controller->update();
+        Output output = takeOutput();
+        checkNack(output, sequence);
+        TEST_ASSERT_EQUAL_UINT32(0, controller->getEventQueue()->getQueueSize());
+    }
+    TEST_ASSERT_EQUAL_UINT32(frameErrors + encodedLength, controller->getCommunication()->getFrameErrors());
+    // The frame is used once it arrives whole
+    sendFrame(sequence, records);
+    controller->update();
+    checkAck(takeOutput(), sequence, 1, 0);
+    sequence++;
+    runUntilIdle();
+    takeOutput();
+}
+
+void test_repeated_frame_is_not_used_again()
+{
+    // The computer did not get the Ack, so it sends the frame again
+    std::vector<uint8_t> records = movementRecord(16);
+    sendFrame(sequence, records);
+    controller->update();
+    checkAck(takeOutput(), sequence, 1, 0);
+    sendFrame(sequence, records);
+    controller->update();
+    checkAck(takeOutput(), sequence, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(1, controller->getEventQueue()->getQueueSize());
+    sequence++;
+    runUntilIdle();
+    takeOutput();
+}
+
+void test_frame_after_a_lost_frame_is_nacked()
+{
+    // The frame before it was lost, only the first frame after the gap is answered
+    sendFrame(sequence + 1, movementRecord(18));
+    sendFrame(sequence + 2, movementRecord(10));
+    controller->update();
+    checkNack(takeOutput(), sequence);
+    TEST_ASSERT_EQUAL_UINT32(0, controller->getEventQueue()->getQueueSize());
+    sendFrame(sequence, movementRecord(18));
+    controller->update();
+    checkAck(takeOutput(), sequence, 1, 0);
+    sequence++;
+    runUntilIdle();
+    takeOutput();
+}
+
+void test_frame_over_credit_is_nacked()
+{
+    EventQueue* eventQueue = controller->getEventQueue();
+    while (eventQueue->getQueueSize() < eventQueue->getQueueCapacity() - 1)
+        eventQueue->addSleepEvent(1000);
+    std::vector<uint8_t> records = movementRecord(20);
+    std::vector<uint8_t> second = movementRecord(10);
+    records.insert(records.end(), second.begin(), second.end());
+    // Only one of the two movements fits, so neither is used
+    sendFrame(sequence, records);
+    controller->update();
+    Output output = takeOutput();
+    checkNack(output, sequence);
+    TEST_ASSERT_EQUAL_UINT16(1, replyValue(output.frames[0], 1));
+
+    // Once enough slots have freed up the computer is told without asking
+    runFor(COMMUNICATION_CREDIT_UPDATE * 1000 + 500);
+    output = takeOutput();
+    TEST_ASSERT_EQUAL_size_t(1, output.frames.size());
+    TEST_ASSERT_EQUAL_size_t(CREDIT_REPLY_SIZE, output.frames[0].size());
+    TEST_ASSERT_EQUAL_UINT8(FRAME_CREDIT, output.frames[0][0]);
+    TEST_ASSERT_EQUAL_UINT16(sequence, replyValue(output.frames[0], 0));
+    TEST_ASSERT_GREATER_OR_EQUAL(1 + COMMUNICATION_CREDIT_UPDATE, replyValue(output.frames[0], 1));
+
+    sendFrame(sequence, records);
+    controller->update();
+    checkAck(takeOutput(), sequence, 2, 0);
+    sequence++;
+    runUntilIdle();
+    takeOutput();
+}
+
+void test_queue_status_is_reported()
+{
+    sendFrame(sequence, requestRecord(QUEUE_STATUS_REQUEST));
+    controller->update();
+    Output output = takeOutput();
+    checkAck(output, sequence, 0, 0);
+    sequence++;
+    TEST_ASSERT_EQUAL_INT(0, output.text.find("Queue Status: 0 " + std::to_string(EVENT_QUEUE_SIZE) + " "));
+}
+
+void test_telemetry_rate_and_sequence()
+{
+    sendFrame(sequence, requestRecord(TELEMETRY_RATE_REQUEST, 200));
+    controller->update();
+    checkAck(takeOutput(), sequence, 0, 0);
+    sequence++;
+    sendFrame(sequence, movementRecord(30));
+    sequence++;
+    runFor(1000000);
+
+    std::vector<std::vector<uint8_t>> telemetry;
+    for (const std::vector<uint8_t>& frame : takeOutput().frames) {
+        if (frame[0] == FRAME_TELEMETRY)
+            telemetry.push_back(frame);
+    }
+    TEST_ASSERT_INT32_WITHIN(1, 200, telemetry.size());
+    uint32_t previousTime = 0;
+    for (size_t i = 0; i < telemetry.size(); i++) {
+        TEST_ASSERT_EQUAL_size_t(TELEMETRY_FRAME_SIZE, telemetry[i].size());
+        uint16_t frameSequence;
+        uint32_t time;
+        memcpy(&frameSequence, &telemetry[i][1], sizeof(frameSequence));
+        memcpy(&time, &telemetry[i][3], sizeof(time));
+        if (i > 0) {
+            TEST_ASSERT_EQUAL_UINT16((uint16_t)(replyValue(telemetry[i - 1], 0) + 1), frameSequence);
+            TEST_ASSERT_UINT32_WITHIN(TEST_LOOP_MICROSECONDS, 5000, time - previousTime);
+        }
+        previousTime = time;
+        // The arm is moving, so the following errors have to stay within the crash threshold
+        TEST_ASSERT_EQUAL_UINT8(0, telemetry[i][TELEMETRY_FRAME_SIZE - 1] & TELEMETRY_FOLLOWING_ERROR);
+    }
+
+    runUntilIdle();
+    takeOutput();
+    sendFrame(sequence, requestRecord(TELEMETRY_RATE_REQUEST, 0));
+    controller->update();
+    checkAck(takeOutput(), sequence, 0, 0);
+    sequence++;
+    runFor(100000);
+    TEST_ASSERT_EQUAL_size_t(0, takeOutput().frames.size());
+}
+
+void test_crash_recovery_is_sent()
+{
+    EventQueue* eventQueue = controller->getEventQueue();
+    Stepper* motors = controller->getSteppers();
+    uint32_t crashes = eventQueue->getLastCrashRecovery()->count;
+    double target[DOF] = { 50, 20, 30, 20, 10, 40 };
+    eventQueue->addMovementEvent(target, 0.5e-4, 1e-10, false);
+    runFor(400000);
+    // The first axis is pushed back, far past the crash threshold
+    motors[0].getEncoder()->write(motors[0].getEncoder()->read() - 2000);
+    runUntilIdle();
+    runFor(1000);
+
+    std::vector<std::vector<uint8_t>> recoveries;
+    for (const std::vector<uint8_t>& frame : takeOutput().frames) {
+        if (frame[0] == FRAME_CRASH_RECOVERY)
+            recoveries.push_back(frame);
+    }
+    // The recovery is sent even though telemetry is off
+    TEST_ASSERT_EQUAL_size_t(1, recoveries.size());
+    TEST_ASSERT_EQUAL_size_t(TELEMETRY_RECOVERY_SIZE, recoveries[0].size());
+    uint32_t count;
+    memcpy(&count, &recoveries[0][1], sizeof(count));
+    TEST_ASSERT_EQUAL_UINT32(crashes + 1, count);
+    TEST_ASSERT_EQUAL_UINT8(1, recoveries[0][5]);
+    // The arm still ends up at its target
+    TEST_ASSERT_EQUAL_INT32(lround(target[0] / motors[0].getDegreeChangePerStep()), motors[0].getCurrentPositionSteps());
+}
+
+int main(int argc, char** argv)
+{
+    hostClock.setManual(true);
+    Serial.setEcho(false);
+    controller = new Controller();
+    UNITY_BEGIN();
+    RUN_TEST(test_frame_is_acked);
+    RUN_TEST(test_invalid_record_is_rejected);
+    RUN_TEST(test_damaged_frame_is_nacked);
+    RUN_TEST(test_repeated_frame_is_not_used_again);
+    RUN_TEST(test_frame_after_a_lost_frame_is_nacked);
+    RUN_TEST(test_frame_over_credit_is_nacked);
+    RUN_TEST(test_queue_status_is_reported);
+    RUN_TEST(test_telemetry_rate_and_sequence);
+    RUN_TEST(test_crash_recovery_is_sent);
+    return UNITY_END();
+}
@@ -0,0 +1,101 @@
+/**
+ * This file contains the tests of the cache of planned movements (see PlanCache.h).
+ *
+ * @author Thomas Batchelder
+ * @file test_main.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#include <unity.h>
+#include "PlanCache.h"
+
+void setUp() { }
+void tearDown() { }
+
+/**
+ * This function is used to make the key of a movement of the first axis
+ * @param target is the target of the first axis in steps
+ * @return is the key of the movement
+ */
+PlanKey makeKey(int32_t target)
+{
+    PlanKey key;
+    memset(&key, 0, sizeof(key));
+    key.targetSteps[0] = target;
+    key.velocity = 1.5e-3f;
+    key.acceleration = 3e-10f;
+    return key;
+}
+
+void test_key_has_no_padding()
+{
+    TEST_ASSERT_EQUAL_size_t(2 * DOF * sizeof(int32_t) + 5 * sizeof(float), sizeof(PlanKey));
+}
+
+void test_lookup_and_store()
+{
+    PlanCache<int, 4> cache;
+    int profile = 0;
+    TEST_ASSERT_FALSE(cache.lookup(makeKey(1), &profile));
+    cache.store(makeKey(1), 10);
+    TEST_ASSERT_TRUE(cache.lookup(makeKey(1), &profile));
+    TEST_ASSERT_EQUAL_INT(10, profile);
+
+    // Any value of the key that differs is a different movement
+    PlanKey key = makeKey(1);
+    key.jerk = 1e-15f;
+    TEST_ASSERT_FALSE(cache.lookup(key, &profile));
+    key = makeKey(1);
+    key.initialSteps[DOF - 1] = 1;
+    TEST_ASSERT_FALSE(cache.lookup(key, &profile));
+
+    TEST_ASSERT_EQUAL_UINT32(1, cache.getHits());
+    TEST_ASSERT_EQUAL_UINT32(3, cache.getMisses());
+    cache.resetStatistics();
+    TEST_ASSERT_EQUAL_UINT32(0, cache.getHits());
+    TEST_ASSERT_EQUAL_UINT32(0, cache.getMisses());
+}
+
+void test_least_recently_used_is_replaced()
+{
+    PlanCache<int, 3> cache;
+    int profile;
+    for (int i = 1; i <= 3; i++)
+        cache.store(makeKey(i), i * 10);
+    // Using the first profile leaves the second as the least recently used
+    TEST_ASSERT_TRUE(cache.lookup(makeKey(1), &profile));
+    cache.store(makeKey(4), 40);
+    TEST_ASSERT_FALSE(cache.lookup(makeKey(2), &profile));
+    TEST_ASSERT_TRUE(cache.lookup(makeKey(1), &profile));
+    TEST_ASSERT_EQUAL_INT(10, profile);
+    TEST_ASSERT_TRUE(cache.lookup(makeKey(3), &profile));
+    TEST_ASSERT_TRUE(cache.lookup(makeKey(4), &profile));
+    TEST_ASSERT_EQUAL_INT(40, profile);
+}
+
+void test_clear()
+{
+    PlanCache<int, 2> cache;
+    int profile;
+    cache.store(makeKey(1), 10);
+    TEST_ASSERT_TRUE(cache.lookup(makeKey(1), &profile));
+    cache.clear();
+    TEST_ASSERT_FALSE(cache.lookup(makeKey(1), &profile));
+    // The counts are kept
+    TEST_ASSERT_EQUAL_UINT32(1, cache.getHits());
+    TEST_ASSERT_EQUAL_UINT32(1, cache.getMisses());
+    // An empty key is not found in an empty cache
+    PlanKey key;
+    memset(&key, 0, sizeof(key));
+    TEST_ASSERT_FALSE(cache.lookup(key, &profile));
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_key_has_no_padding);
+    RUN_TEST(test_lookup_and_store);
+    RUN_TEST(test_least_recently_used_is_replaced);
+    RUN_TEST(test_clear);
+    return UNITY_END();
+}
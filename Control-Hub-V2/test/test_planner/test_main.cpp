@@ -0,0 +1,197 @@
+/**
+ * This file contains the tests of the movement planner: the trapezoid and S-curve profiles, the
+ * limits of each axis, the look-ahead between movements and the plan cache. The arm runs on the
+ * virtual clock (see HostArduino.h), so every run steps exactly the same way.
+ *
+ * @author Thomas Batchelder
+ * @file test_main.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#include <unity.h>
+#include "Controller.h"
+
+/** Time the virtual clock moves for each main loop */
+#define TEST_LOOP_MICROSECONDS 20
+/** Time between the positions sampled while the arm moves */
+#define TEST_SAMPLE_MICROSECONDS 50000
+/** Most samples kept of a run */
+#define TEST_MAX_SAMPLES 1024
+/** Allowance on the limits, on top of the error of sampling whole steps */
+#define TEST_LIMIT_TOLERANCE 1.05
+
+/** The movements of every test build on the position left by the test before it */
+Controller* controller;
+
+/** What was seen of a movement while the arm followed it */
+struct Motion {
+    /** Largest velocity (degrees per second) and acceleration (degrees per second squared) of each axis */
+    double maxVelocity[DOF], maxAcceleration[DOF];
+    /** Largest change of the acceleration of the first axis between two samples */
+    double maxAccelerationChange;
+    /** Velocity of the first axis at each sample */
+    double firstAxisVelocity[TEST_MAX_SAMPLES];
+    int samples;
+};
+
+void setUp() { }
+void tearDown() { }
+
+/**
+ * This function is used to run the main loop until every event is completed, while the positions are sampled
+ * @return is what was seen of the movements
+ */
+Motion runUntilIdle()
+{
+    Motion motion = {};
+    Stepper* motors = controller->getSteppers();
+    double previous[DOF], velocity[DOF] = { 0 }, acceleration = 0;
+    for (int i = 0; i < DOF; i++)
+        previous[i] = motors[i].getCurrentPositionDegrees();
+    double sampleTime = hostClock.now() + TEST_SAMPLE_MICROSECONDS;
+    while (controller->isActive()) {
+        controller->update();
+        hostClock.advance(TEST_LOOP_MICROSECONDS);
+        if (hostClock.now() < sampleTime)
+            continue;
+        sampleTime += TEST_SAMPLE_MICROSECONDS;
+        for (int i = 0; i < DOF; i++) {
+            double position = motors[i].getCurrentPositionDegrees();
+            double newVelocity = (position - previous[i]) * SECONDS_TO_MICROSECONDS / TEST_SAMPLE_MICROSECONDS;
+            double newAcceleration = (newVelocity - velocity[i]) * SECONDS_TO_MICROSECONDS / TEST_SAMPLE_MICROSECONDS;
+            motion.maxVelocity[i] = max(motion.maxVelocity[i], fabs(newVelocity));
+            motion.maxAcceleration[i] = max(motion.maxAcceleration[i], fabs(newAcceleration));
+            if (i == 0) {
+                motion.maxAccelerationChange = max(motion.maxAccelerationChange, fabs(newAcceleration - acceleration));
+                acceleration = newAcceleration;
+                if (motion.samples < TEST_MAX_SAMPLES)
+                    motion.firstAxisVelocity[motion.samples++] = newVelocity;
+            }
+            previous[i] = position;
+            velocity[i] = newVelocity;
+        }
+    }
+    return motion;
+}
+
+/**
+ * This function is used to check every axis ended on the step closest to its target, and its encoder
+ * agrees to within the rounding of the encoder counts to steps
+ * @param target is the target of each axis in degrees
+ */
+void checkAtTarget(const double* target)
+{
+    Stepper* motors = controller->getSteppers();
+    for (int i = 0; i < DOF; i++) {
+        TEST_ASSERT_EQUAL_INT32(lround(target[i] / motors[i].getDegreeChangePerStep()), motors[i].getCurrentPositionSteps());
+        TEST_ASSERT_INT32_WITHIN(1, motors[i].getCurrentPositionSteps(), motors[i].readEncoderPosition());
+    }
+}
+
+/**
+ * This function is used to check no axis went faster or accelerated harder than its limits. Each
+ * sampled position can be up to a step off, which adds up to two steps to each velocity and up to
+ * four steps to each acceleration worked out from them.
+ * @param motion is what was seen of the movement
+ * @param hasCorners is true if the movements meet at corners, where the velocity of each axis changes at once
+ * (see JUNCTION_DEVIATION) so only the velocity is checked
+ */
+void checkWithinLimits(const Motion& motion, bool hasCorners = false)
+{
+    Stepper* motors = controller->getSteppers();
+    double sampleSeconds = TEST_SAMPLE_MICROSECONDS / SECONDS_TO_MICROSECONDS;
+    for (int i = 0; i < DOF; i++) {
+        double step = motors[i].getDegreeChangePerStep();
+        double maxVelocity = motors[i].getMaxVelocity() * SECONDS_TO_MICROSECONDS;
+        double maxAcceleration = motors[i].getMaxAcceleration() * SECONDS_TO_MICROSECONDS * SECONDS_TO_MICROSECONDS;
+        TEST_ASSERT_LESS_OR_EQUAL(maxVelocity * TEST_LIMIT_TOLERANCE + 2 * step / sampleSeconds, motion.maxVelocity[i]);
+        if (!hasCorners)
+            TEST_ASSERT_LESS_OR_EQUAL(maxAcceleration * TEST_LIMIT_TOLERANCE + 4 * step / sq(sampleSeconds), motion.maxAcceleration[i]);
+    }
+}
+
+void test_trapezoid_reaches_target()
+{
+    // Asks for far more than any axis can do, so every axis is held to its own limits
+    double target[DOF] = { 200, 100, 50, 20, 10, 40 };
+    TEST_ASSERT_TRUE(controller->getEventQueue()->addMovementEvent(target, MAX_VELOCITY, 1e-9, false));
+    Motion motion = runUntilIdle();
+    checkAtTarget(target);
+    checkWithinLimits(motion);
+    TEST_ASSERT_GREATER_THAN(0, motion.maxVelocity[0]);
+}
+
+void test_s_curve_reaches_target()
+{
+    double start[DOF] = { 10, 10, 10, 10, 10, 10 };
+    double target[DOF] = { 200, 100, 50, 20, 10, 40 };
+    controller->getEventQueue()->addMovementEvent(start, MAX_VELOCITY, 1e-9, false);
+    runUntilIdle();
+    controller->getEventQueue()->addMovementEvent(target, MAX_VELOCITY, 1e-9, false);
+    Motion trapezoid = runUntilIdle();
+
+    controller->getEventQueue()->addMovementEvent(start, MAX_VELOCITY, 1e-9, false);
+    runUntilIdle();
+    TEST_ASSERT_TRUE(controller->getEventQueue()->addMovementEvent(target, MAX_VELOCITY, 1e-9, false, 2e-15));
+    Motion sCurve = runUntilIdle();
+    checkAtTarget(target);
+    checkWithinLimits(sCurve);
+    // The jerk limit spreads each change of acceleration out
+    TEST_ASSERT_LESS_THAN(trapezoid.maxAccelerationChange, sCurve.maxAccelerationChange);
+}
+
+void test_look_ahead_keeps_moving()
+{
+    double start[DOF] = { 10, 10, 10, 10, 10, 10 };
+    controller->getEventQueue()->addMovementEvent(start, MAX_VELOCITY, 1e-9, false);
+    runUntilIdle();
+    // A dense polyline of short movements, the arm should pass through the corners without stopping
+    double target[DOF];
+    for (int k = 1; k <= 20; k++) {
+        for (int i = 0; i < DOF; i++)
+            target[i] = 10 + k * 2.0 + (i == 1 ? (k % 2) * 0.2 : 0);
+        TEST_ASSERT_TRUE(controller->getEventQueue()->addMovementEvent(target, HOMING_VELOCITY * 6, HOMING_ACCELERATION * 6, false));
+    }
+    Motion motion = runUntilIdle();
+    checkAtTarget(target);
+    checkWithinLimits(motion, true);
+    // Stopping or slowing down at a corner would show up as a dip, with look-ahead the first axis only speeds
+    // up to its peak and slows down from it. The dip allowed is the error of sampling whole steps.
+    double dip = 2 * controller->getSteppers()[0].getDegreeChangePerStep() * SECONDS_TO_MICROSECONDS / TEST_SAMPLE_MICROSECONDS;
+    TEST_ASSERT_GREATER_THAN(10, motion.samples);
+    double fastestBefore = 0;
+    for (int i = 0; i < motion.samples; i++) {
+        double fastestAfter = 0;
+        for (int j = i + 1; j < motion.samples; j++)
+            fastestAfter = max(fastestAfter, motion.firstAxisVelocity[j]);
+        TEST_ASSERT_GREATER_OR_EQUAL(min(fastestBefore, fastestAfter) - dip, motion.firstAxisVelocity[i]);
+        fastestBefore = max(fastestBefore, motion.firstAxisVelocity[i]);
+    }
+}
+
+void test_repeated_movements_use_plan_cache()
+{
+    double a[DOF] = { 20, 10, 10, 10, 10, 10 };
+    double b[DOF] = { 10, 20, 10, 10, 10, 10 };
+    EventQueue* eventQueue = controller->getEventQueue();
+    for (int loop = 0; loop < 5; loop++) {
+        eventQueue->addMovementEvent(a, 0.5e-4, 1e-10, false);
+        eventQueue->addMovementEvent(b, 0.5e-4, 1e-10, false);
+        runUntilIdle();
+    }
+    checkAtTarget(b);
+    TEST_ASSERT_GREATER_THAN(0, eventQueue->getPlanCacheHits());
+}
+
+int main(int argc, char** argv)
+{
+    hostClock.setManual(true);
+    Serial.setEcho(false);
+    controller = new Controller();
+    UNITY_BEGIN();
+    RUN_TEST(test_trapezoid_reaches_target);
+    RUN_TEST(test_s_curve_reaches_target);
+    RUN_TEST(test_look_ahead_keeps_moving);
+    RUN_TEST(test_repeated_movements_use_plan_cache);
+    return UNITY_END();
+}
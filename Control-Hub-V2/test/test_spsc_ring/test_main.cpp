@@ -0,0 +1,124 @@
+/**
+ * This file contains the tests of the single producer, single consumer ring buffer (see SpscRing.h).
+ *
+ * @author Thomas Batchelder
+ * @file test_main.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#include <unity.h>
+#include <thread>
+#include "SpscRing.h"
+
+void setUp() { }
+void tearDown() { }
+
+void test_push_pop_order()
+{
+    SpscRing<uint32_t, 8> ring;
+    TEST_ASSERT_TRUE(ring.isEmpty());
+    TEST_ASSERT_NULL(ring.front());
+    for (uint32_t i = 0; i < 8; i++)
+        TEST_ASSERT_TRUE(ring.push(i));
+    TEST_ASSERT_TRUE(ring.isFull());
+    TEST_ASSERT_FALSE(ring.push(8));
+    TEST_ASSERT_EQUAL_UINT32(8, ring.size());
+    for (uint32_t i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL_UINT32(i, *ring.front());
+        ring.pop();
+    }
+    TEST_ASSERT_TRUE(ring.isEmpty());
+    // Popping an empty ring does nothing
+    ring.pop();
+    TEST_ASSERT_EQUAL_UINT32(0, ring.size());
+}
+
+void test_wraps_around()
+{
+    SpscRing<uint32_t, 4> ring;
+    uint32_t next = 0, expected = 0;
+    for (int round = 0; round < 100; round++) {
+        while (ring.push(next))
+            next++;
+        TEST_ASSERT_EQUAL_UINT32(4, ring.size());
+        // Leave a different number of items behind each round, so the indices wrap at every position
+        for (int i = 0; i < 1 + round % 4; i++) {
+            TEST_ASSERT_EQUAL_UINT32(expected++, *ring.front());
+            ring.pop();
+        }
+    }
+}
+
+void test_reserve_commit()
+{
+    SpscRing<uint32_t, 8> ring;
+    ring.push(100);
+    // Reserved items are not seen by the consumer until they are committed
+    for (uint32_t i = 0; i < 7; i++)
+        *ring.reserve(i) = i;
+    TEST_ASSERT_NULL(ring.reserve(7));
+    TEST_ASSERT_EQUAL_UINT32(1, ring.size());
+    TEST_ASSERT_NULL(ring.at(1));
+    ring.commit(3);
+    TEST_ASSERT_EQUAL_UINT32(4, ring.size());
+    TEST_ASSERT_EQUAL_UINT32(100, *ring.at(0));
+    TEST_ASSERT_EQUAL_UINT32(2, *ring.at(3));
+    TEST_ASSERT_NULL(ring.at(4));
+    TEST_ASSERT_EQUAL_UINT32((ring.indexOf(ring.front()) + 3) & 7, ring.indexOf(ring.at(3)));
+    // Slots reserved but not committed are given out again
+    TEST_ASSERT_NOT_NULL(ring.reserve(3));
+    TEST_ASSERT_NULL(ring.reserve(4));
+}
+
+void test_copy()
+{
+    SpscRing<uint32_t, 4> ring;
+    ring.push(1);
+    ring.push(2);
+    ring.pop();
+    ring.push(3);
+    SpscRing<uint32_t, 4> copy(ring);
+    TEST_ASSERT_EQUAL_UINT32(2, copy.size());
+    TEST_ASSERT_EQUAL_UINT32(2, *copy.at(0));
+    TEST_ASSERT_EQUAL_UINT32(3, *copy.at(1));
+}
+
+void test_two_threads()
+{
+    // The producer and the consumer run at once, every item has to arrive once and in order
+    static SpscRing<uint32_t, 64> ring;
+    const uint32_t count = 100000;
+    std::thread producer([]() {
+        for (uint32_t i = 0; i < count;) {
+            if (ring.push(i))
+                i++;
+            else
+                std::this_thread::yield();
+        }
+    });
+    uint32_t expected = 0;
+    bool inOrder = true;
+    while (expected < count) {
+        uint32_t* item = ring.front();
+        if (item == NULL) {
+            std::this_thread::yield();
+            continue;
+        }
+        inOrder &= *item == expected++;
+        ring.pop();
+    }
+    producer.join();
+    TEST_ASSERT_TRUE(inOrder);
+    TEST_ASSERT_TRUE(ring.isEmpty());
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_push_pop_order);
+    RUN_TEST(test_wraps_around);
+    RUN_TEST(test_reserve_commit);
+    RUN_TEST(test_copy);
+    RUN_TEST(test_two_threads);
+    return UNITY_END();
+}
@@ -0,0 +1,193 @@
+/**
+ * This file contains the tests of the streams of setpoints: the linear and cubic interpolation,
+ * running out of setpoints and the timeout of a stream that is never sent. The setpoints arrive
+ * with a jitter like they would over USB, and the arm runs on the virtual clock (see HostArduino.h).
+ *
+ * @author Thomas Batchelder
+ * @file test_main.cpp
+ * @date 10/17/2026 - File created
+ */
+
+#include <unity.h>
+#include <stdlib.h>
+#include "Controller.h"
+
+/** Time the virtual clock moves for each main loop */
+#define TEST_LOOP_MICROSECONDS 20
+/** Length of each streamed trajectory */
+#define TEST_STREAM_MICROSECONDS 2000000
+/** Most a setpoint arrives after its timestamp */
+#define TEST_JITTER_MICROSECONDS 3000
+/** Playback delay of each stream, covers the jitter and the setpoint after a segment that cubic interpolation needs */
+#define TEST_PLAYBACK_DELAY 20000
+/** Longest lag looked at when lining the path of the arm up with the trajectory */
+#define TEST_MAX_LAG_MICROSECONDS 60000
+
+/** The streams of every test start from the position left by the test before it */
+Controller* controller;
+
+/** What was seen of a stream while the arm followed it */
+struct StreamRun {
+    /** Largest distance of the first two axes from the trajectory in degrees, once the lag is taken out */
+    double maxError;
+    /** Number of times the stream ran out of setpoints */
+    uint32_t underruns;
+};
+
+void setUp() { }
+void tearDown() { }
+
+/**
+ * This function is used to get a point of the streamed trajectory
+ * @param time is the time since the start of the trajectory in microseconds
+ * @param axis is the axis
+ * @return is the angle of the axis in degrees
+ */
+double trajectory(double time, int axis)
+{
+    if (axis == 0)
+        return 10 + 5 * sin(2 * M_PI * 0.5 * time / SECONDS_TO_MICROSECONDS);
+    if (axis == 1)
+        return 10 + 3 * (1 - cos(2 * M_PI * 0.25 * time / SECONDS_TO_MICROSECONDS));
+    return 10;
+}
+
+/**
+ * This function is used to run the main loop until every event is completed
+ */
+void runUntilIdle()
+{
+    while (controller->isActive()) {
+        controller->update();
+        hostClock.advance(TEST_LOOP_MICROSECONDS);
+    }
+}
+
+/**
+ * This function is used to stream the trajectory to the arm, each setpoint arrives after its
+ * timestamp by up to the jitter, and the setpoints due in the gap only arrive at its end
+ * @param interpolation is how the arm moves between the setpoints (STREAM_LINEAR or STREAM_CUBIC)
+ * @param rate is the number of setpoints each second
+ * @param gapStart is the time of the gap from the start of the stream in microseconds
+ * @param gapLength is the length of the gap in microseconds, 0 for no gap
+ * @return is what was seen of the stream
+ */
+StreamRun streamTrajectory(uint8_t interpolation, double rate, double gapStart, double gapLength)
+{
+    static double samples[2][TEST_STREAM_MICROSECONDS / 1000 + 2000];
+    EventQueue* eventQueue = controller->getEventQueue();
+    Stepper* motors = controller->getSteppers();
+    double start[DOF];
+    for (int i = 0; i < DOF; i++)
+        start[i] = trajectory(0, i);
+    eventQueue->addMovementEvent(start, MAX_VELOCITY, 1e-9, false);
+    runUntilIdle();
+    uint32_t underruns = eventQueue->getStreamUnderruns();
+    TEST_ASSERT_TRUE(eventQueue->addStreamEvent(TEST_PLAYBACK_DELAY, interpolation));
+
+    double period = SECONDS_TO_MICROSECONDS / rate;
+    int count = TEST_STREAM_MICROSECONDS / period + 1;
+    // The timestamps of the computer start anywhere, and wrap around
+    uint32_t timestampOffset = 0xFFFFFFFF - TEST_STREAM_MICROSECONDS / 2;
+    srand(1);
+    double arrival = 0, startTime = hostClock.now();
+    int sent = 0, sampleCount = 0;
+    bool isSending = true;
+    while (isSending || controller->isActive()) {
+        double now = hostClock.now() - startTime;
+        while (sent < count && now >= arrival) {
+            double position[DOF];
+            for (int i = 0; i < DOF; i++)
+                position[i] = trajectory(sent * period, i);
+            TEST_ASSERT_TRUE(eventQueue->addSetpoint(timestampOffset + (uint32_t)(sent * period), position, sent == count - 1));
+            sent++;
+            arrival = sent * period + rand() % TEST_JITTER_MICROSECONDS;
+            if (sent * period >= gapStart && sent * period < gapStart + gapLength)
+                arrival = gapStart + gapLength;
+        }
+        isSending = sent < count;
+        controller->update();
+        hostClock.advance(TEST_LOOP_MICROSECONDS);
+        // The positions are sampled every millisecond
+        if ((int)(now / 1000) >= sampleCount && sampleCount < (int)(sizeof(samples[0]) / sizeof(samples[0][0]))) {
+            for (int i = 0; i < 2; i++)
+                samples[i][sampleCount] = motors[i].getCurrentPositionDegrees();
+            sampleCount++;
+        }
+    }
+
+    // The arm follows the trajectory a playback delay behind, so the error is measured at the lag that fits best.
+    // The start, the end and the gap are left out, the arm is catching up there.
+    StreamRun run = { 1e9, eventQueue->getStreamUnderruns() - underruns };
+    for (double lag = 0; lag <= TEST_MAX_LAG_MICROSECONDS; lag += 250) {
+        double error = 0;
+        for (int sample = 0; sample < sampleCount; sample++) {
+            double time = sample * 1000.0 - lag;
+            if (time < 100000 || time > TEST_STREAM_MICROSECONDS - 100000)
+                continue;
+            if (gapLength > 0 && time >= gapStart - 20000 && time < gapStart + gapLength + 60000)
+                continue;
+            for (int i = 0; i < 2; i++)
+                error = max(error, fabs(samples[i][sample] - trajectory(time, i)));
+        }
+        run.maxError = min(run.maxError, error);
+    }
+
+    // The stream ends on its last setpoint
+    TEST_ASSERT_EQUAL_UINT32(0, eventQueue->getBufferedSetpoints());
+    for (int i = 0; i < DOF; i++) {
+        double target = trajectory((count - 1) * period, i);
+        TEST_ASSERT_EQUAL_INT32(lround(target / motors[i].getDegreeChangePerStep()), motors[i].getCurrentPositionSteps());
+    }
+    return run;
+}
+
+void test_linear_follows_trajectory()
+{
+    StreamRun run = streamTrajectory(STREAM_LINEAR, 100, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, run.underruns);
+    TEST_ASSERT_LESS_OR_EQUAL(0.1, run.maxError);
+}
+
+void test_cubic_follows_trajectory()
+{
+    StreamRun run = streamTrajectory(STREAM_CUBIC, 500, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, run.underruns);
+    TEST_ASSERT_LESS_OR_EQUAL(0.05, run.maxError);
+}
+
+void test_underrun_recovers()
+{
+    // The setpoints stop for longer than the playback delay, the arm waits for them and carries on
+    StreamRun run = streamTrajectory(STREAM_CUBIC, 500, 1000000, 100000);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, run.underruns);
+    TEST_ASSERT_LESS_OR_EQUAL(0.05, run.maxError);
+}
+
+void test_stream_times_out()
+{
+    EventQueue* eventQueue = controller->getEventQueue();
+    Stepper* motors = controller->getSteppers();
+    int32_t position = motors[0].getCurrentPositionSteps();
+    TEST_ASSERT_TRUE(eventQueue->addStreamEvent(TEST_PLAYBACK_DELAY, STREAM_CUBIC));
+    double startTime = hostClock.now();
+    runUntilIdle();
+    // A stream that is never sent is ended once it has waited for the timeout, without moving the arm
+    TEST_ASSERT_GREATER_OR_EQUAL(STREAM_TIMEOUT_MICROSECONDS, hostClock.now() - startTime);
+    TEST_ASSERT_LESS_THAN(STREAM_TIMEOUT_MICROSECONDS + 10000, hostClock.now() - startTime);
+    TEST_ASSERT_EQUAL_INT32(position, motors[0].getCurrentPositionSteps());
+    TEST_ASSERT_EQUAL_UINT32(0, eventQueue->getQueueSize());
+}
+
+int main(int argc, char** argv)
+{
+    hostClock.setManual(true);
+    Serial.setEcho(false);
+    controller = new Controller();
+    UNITY_BEGIN();
+    RUN_TEST(test_linear_follows_trajectory);
+    RUN_TEST(test_cubic_follows_trajectory);
+    RUN_TEST(test_underrun_recovers);
+    RUN_TEST(test_stream_times_out);
+    return UNITY_END();
+}
@@ -1,11 +1,15 @@
-from time import sleep
+from collections import deque
+from time import sleep, time
+import json
 import serial
 import struct
 
 ser = serial.Serial("COM5", 250000)
 
-speed = 0.5e-3
-acceleration = 1.0e-10
+# Requested for the axis that moves the most, the firmware slows a movement down to the limits of each axis
+speed = 1.5e-3
+acceleration = 3.0e-10
+jerk = 0 # 0 for a trapezoid profile, otherwise the jerk of an S-curve profile
 
 print("Starting...")
 sleep(0.5)
@@ -19,87 +23,401 @@ print("Connected!")
 #    arduino_input = dataRecived.decode("ascii")
 
 
+MOVEMENT_EVENT = 1
+SLEEP_EVENT = 2
+HOMING_EVENT = 3
+QUEUE_STATUS_REQUEST = 4
+STREAM_EVENT = 5
+STREAM_SETPOINT = 6
+TELEMETRY_RATE_REQUEST = 7
+
+STREAM_LINEAR = 0
+STREAM_CUBIC = 1
+SETPOINT_END_OF_STREAM = 0x01
+
+def crc16(data):
+    # CRC-16/CCITT-FALSE, the same CRC as calculateCrc16 in Framing.cpp
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+def encodeCobs(data):
+    output = bytearray([0])
+    codeIndex = 0
+    code = 1
+    for byte in data:
+        if byte != 0:
+            output.append(byte)
+            code += 1
+        if byte == 0 or code == 0xFF:
+            output[codeIndex] = code
+            codeIndex = len(output)
+            output.append(0)
+            code = 1
+    output[codeIndex] = code
+    return bytes(output)
+
+def decodeCobs(data):
+    output = bytearray()
+    index = 0
+    while index < len(data):
+        code = data[index]
+        if code == 0 or index + code > len(data):
+            return None
+        output += data[index + 1:index + code]
+        index += code
+        if code != 0xFF and index < len(data):
+            output.append(0)
+    return bytes(output)
+
+def movementRecord(angles, velocity, acceleration, jerk=0, useEncoderPosition=False):
+    return struct.pack("<B6f3fB", MOVEMENT_EVENT, *angles, velocity, acceleration, jerk, 1 if useEncoderPosition else 0)
+
+def sleepRecord(microseconds):
+    return struct.pack("<BI", SLEEP_EVENT, microseconds)
+
+def homingRecord(velocity, acceleration):
+    return struct.pack("<B2f", HOMING_EVENT, velocity, acceleration)
+
+def streamRecord(playbackDelay, interpolation=STREAM_CUBIC):
+    # The arm follows the setpoints playbackDelay microseconds behind the newest one it has received
+    return struct.pack("<BIB", STREAM_EVENT, playbackDelay, interpolation)
+
+def setpointRecord(timestamp, angles, isEnd=False):
+    # The timestamp is in microseconds on the computer's clock, it only has to go up by the time between setpoints
+    return struct.pack("<BI6fB", STREAM_SETPOINT, timestamp & 0xFFFFFFFF, *angles, SETPOINT_END_OF_STREAM if isEnd else 0)
+
+def telemetryRateRecord(rate):
+    # Frames sent each second (0 is off)
+    return struct.pack("<BH", TELEMETRY_RATE_REQUEST, rate)
+
+# Type of each frame sent by the Teensy, the first byte of the frame
+FRAME_TELEMETRY = 1
+FRAME_CRASH_RECOVERY = 2
+FRAME_ACK = 3 # sequence, records accepted, records rejected, credits
+FRAME_NACK = 4 # expected sequence, credits, every frame from the expected one is sent again
+FRAME_CREDIT = 5 # expected sequence, credits
+REPLY_FORMATS = {FRAME_ACK: "<B4H", FRAME_NACK: "<B2H", FRAME_CREDIT: "<B2H"}
+
+# Telemetry frame: type, sequence, time (us), motor steps, encoder steps, following error (steps), queue depth,
+# buffered setpoints, loops and longest loop (us) since the last frame, error flags
+TELEMETRY_FORMAT = "<BHI6i6i6iHHHIB"
+TELEMETRY_FLAGS = ["following error", "crash recovery", "stream underrun", "frame error", "event rejected", "telemetry dropped"]
+# Crash recovery frame: type, count, axis, motor steps, encoder steps, detected at (us), deceleration time (us),
+# settle time (us), new velocity (degrees/us)
+CRASH_RECOVERY_FORMAT = "<BIBiiIIIf"
+
+def decodeFrame(frame):
+    # Returns the frame without its CRC, or None if it was damaged
+    data = decodeCobs(frame)
+    if data is None or len(data) < 3 or crc16(data[:-2]) != struct.unpack("<H", data[-2:])[0]:
+        return None
+    return data[:-2]
+
+def decodeTelemetry(data):
+    if len(data) != struct.calcsize(TELEMETRY_FORMAT):
+        return None
+    values = struct.unpack(TELEMETRY_FORMAT, data)[1:]
+    return {
+        "sequence": values[0],
+        "time": values[1],
+        "motorSteps": values[2:8],
+        "encoderSteps": values[8:14],
+        "followingError": values[14:20],
+        "queueDepth": values[20],
+        "bufferedSetpoints": values[21],
+        "loops": values[22],
+        "longestLoop": values[23],
+        "flags": [name for bit, name in enumerate(TELEMETRY_FLAGS) if values[24] & (1 << bit)],
+    }
+
+def decodeCrashRecovery(data):
+    if len(data) != struct.calcsize(CRASH_RECOVERY_FORMAT):
+        return None
+    values = struct.unpack(CRASH_RECOVERY_FORMAT, data)[1:]
+    return {
+        "count": values[0],
+        "axis": values[1],
+        "motorSteps": values[2],
+        "encoderSteps": values[3],
+        "detectedTime": values[4],
+        "decelerationTime": values[5],
+        "settleTime": values[6],
+        "velocity": values[7],
+    }
+
+FRAME_RECORD_BYTES = 500 # Records sent in one frame, keeps the encoded frame well within the 1024 bytes the Teensy accepts
+WINDOW_FRAMES = 4 # Frames sent before waiting for a reply, keeps the Teensy's USB receive buffer from filling up
+RESEND_TIMEOUT = 0.5 # Seconds without a reply after which the unanswered frames are sent again
+
+def isBefore(a, b):
+    # Compares two 16 bit sequence numbers that wrap around
+    return ((a - b) & 0xFFFF) >= 0x8000
+
+class Link:
+    """
+    Sends records to the Teensy in sequence numbered frames. Events are only sent while they fit in
+    the credits (free event queue slots) the Teensy has advertised, less the events in frames that
+    have not been answered, so several frames can be in flight without the queue overflowing.
+    """
+
+    def __init__(self, port):
+        self.port = port
+        self.sequence = 0
+        self.credits = 0
+        self.waiting = deque() # (records, events) not sent yet
+        self.unanswered = deque() # (sequence, encoded frame, events) sent but not answered
+        self.lastSend = time()
+        self.received = b""
+        self.telemetry = None # Newest telemetry frame
+        self.crashRecovery = None # Last crash the Teensy recovered from
+        self.frameErrors = 0 # Frames from the Teensy that were damaged
+        self.lineHandler = None # Called with each line that is not a reply, the line is only printed if it returns False
+        # An empty frame is answered with the number of credits
+        self.waiting.append(([], 0))
+
+    def send(self, records):
+        # Records are split into frames, nothing waits for the Teensy here, call pump() or flush()
+        frame = []
+        for record in records:
+            if frame and sum(len(r) for r in frame) + len(record) > FRAME_RECORD_BYTES:
+                self.waiting.append((frame, self.countEvents(frame)))
+                frame = []
+            frame.append(record)
+        if frame:
+            self.waiting.append((frame, self.countEvents(frame)))
+        self.pump()
+
+    def countEvents(self, records):
+        # Setpoints go to the stream rather than the event queue, so they do not use credits
+        return sum(1 for record in records if record[0] not in (QUEUE_STATUS_REQUEST, STREAM_SETPOINT))
+
+    def pump(self):
+        self.readReplies()
+        if self.unanswered and time() - self.lastSend > RESEND_TIMEOUT:
+            self.resend()
+        while self.waiting and len(self.unanswered) < WINDOW_FRAMES:
+            records, events = self.waiting[0]
+            if events > self.credits - sum(frame[2] for frame in self.unanswered):
+                break
+            self.waiting.popleft()
+            data = struct.pack("<H", self.sequence) + b"".join(records)
+            data += struct.pack("<H", crc16(data))
+            frame = encodeCobs(data) + b"\x00"
+            self.unanswered.append((self.sequence, frame, events))
+            self.sequence = (self.sequence + 1) & 0xFFFF
+            self.port.write(frame)
+            self.lastSend = time()
+
+    def flush(self):
+        while self.waiting or self.unanswered:
+            self.pump()
+            sleep(0.001)
+
+    def resend(self):
+        for frame in self.unanswered:
+            self.port.write(frame[1])
+        self.lastSend = time()
+
+    def answered(self, sequence, credits):
+        # Every frame before the sequence has been used by the Teensy
+        while self.unanswered and isBefore(self.unanswered[0][0], sequence):
+            self.unanswered.popleft()
+        self.credits = credits
+        self.lastSend = time()
+
+    def readReplies(self):
+        if self.port.inWaiting() > 0:
+            self.received += self.port.read(self.port.inWaiting())
+        while True:
+            # Frames sit between two zero bytes, which never appear in the text lines
+            if self.received.startswith(b"\x00"):
+                end = self.received.find(b"\x00", 1)
+                if end < 0:
+                    break
+                frame = self.received[1:end]
+                if not frame:
+                    # The first zero ended a frame that started before the port was opened
+                    self.received = self.received[1:]
+                    continue
+                self.received = self.received[end + 1:]
+                data = decodeFrame(frame)
+                if data is not None and data[0] in REPLY_FORMATS:
+                    data = self.handleReply(data)
+                elif data is not None and data[0] == FRAME_TELEMETRY:
+                    data = decodeTelemetry(data)
+                    if data is not None:
+                        self.telemetry = data
+                elif data is not None and data[0] == FRAME_CRASH_RECOVERY:
+                    data = decodeCrashRecovery(data)
+                    if data is not None:
+                        self.crashRecovery = data
+                        print("Teensy: Crash Recovery: " + json.dumps(data))
+                if data is None:
+                    self.frameErrors += 1
+                continue
+            end = self.received.find(b"\n")
+            frameStart = self.received.find(b"\x00")
+            if frameStart > 0 and (end < 0 or frameStart < end):
+                # Bytes before a frame that are not a whole line, only seen when bytes were lost
+                print("Teensy: " + self.received[:frameStart].decode("ascii", "replace"))
+                self.received = self.received[frameStart:]
+                continue
+            if end < 0:
+                break
+            line, self.received = self.received[:end], self.received[end + 1:]
+            line = line.decode("ascii").rstrip("\r")
+            if self.lineHandler is None or not self.lineHandler(line):
+                print("Teensy: " + line)
+
+    def handleReply(self, data):
+        # Returns None if the reply is damaged
+        if len(data) != struct.calcsize(REPLY_FORMATS[data[0]]):
+            return None
+        values = struct.unpack(REPLY_FORMATS[data[0]], data)
+        if values[0] == FRAME_ACK:
+            self.answered((values[1] + 1) & 0xFFFF, values[4])
+            if values[3] > 0:
+                print("Teensy: Ack: %d %d %d %d" % values[1:])
+        else:
+            self.answered(values[1], values[2])
+            if values[0] == FRAME_NACK:
+                self.resend()
+        return values
+
+link = Link(ser)
+
 def sendMovement1(axis1, axis2, axis3, axis4, axis6):
-    data = [1, axis1, axis2, axis3, axis4, 0, axis6, speed, acceleration, 0, 0, 0, -1]
-    print(len(data))
-    print(data)
-    for i in range(len(data)):
-        ser.write(struct.pack("d", float(data[i])))
-        print("\nWriting " + str(data[i]) + " to Teensy")
-        dataRecived = ser.read_until(b"\n")
-        print("Teensy: " + dataRecived.decode("ascii")[:-2])
-        dataRecived = ser.read_until(b"\n")
-        print("Teensy: " + dataRecived.decode("ascii")[:-2])
-    while ser.inWaiting() > 0:
-            dataRecived = ser.read_until(b"\n")
-            print("Teensy: " + dataRecived.decode("ascii")[:-2])
-    print("Done!")
+    link.send([movementRecord([axis1, axis2, axis3, axis4, 0, axis6], speed, acceleration, jerk)])
 
 def goHome():
-    data = [1, 170, 35.45, 142.6, 160, 71.5, 150, speed, acceleration, 0, 0, 0, -1]
-    print(len(data))
-    print(data)
-    for i in range(len(data)):
-        ser.write(struct.pack("d", float(data[i])))
-        print("\nWriting " + str(data[i]) + " to Teensy")
-        dataRecived = ser.read_until(b"\n")
-        print("Teensy: " + dataRecived.decode("ascii")[:-2])
-        dataRecived = ser.read_until(b"\n")
-        print("Teensy: " + dataRecived.decode("ascii")[:-2])
-    while ser.inWaiting() > 0:
-            dataRecived = ser.read_until(b"\n")
-            print("Teensy: " + dataRecived.decode("ascii")[:-2])
-    print("Done!")
-
-#goHome()
-goHome()
-
-for num in range(1):
-    #sendMovement1(250, 36 + 90, 120, 142.5, 180)
-    sendMovement1(170, 150, 60 + 180, 142.5, 180)
-    sendMovement1(80, 50, 180, 142.5, 180)
-    sendMovement1(80, 110, 90, 142.5, 180)
+    link.send([movementRecord([170, 35.45, 142.6, 160, 71.5, 150], speed, acceleration, jerk)])
+
+def requestQueueStatus():
+    # Reply: "Queue Status: <depth> <capacity> <high water mark> <rejected events> <queue bytes> <plan cache hits> <plan cache misses> <frame errors>
+    # <buffered setpoints> <stream underruns>"
+    link.send([struct.pack("<B", QUEUE_STATUS_REQUEST)])
+    link.flush()
+
+def setTelemetryRate(rate):
+    # The newest frame is kept in link.telemetry, for example 100 to watch the arm at 100 Hz
+    link.send([telemetryRateRecord(rate)])
+    link.flush()
+
+STREAM_BATCH_SETPOINTS = 4 # Setpoints sent in one frame while streaming, fewer frames at the cost of a little latency
+
+def streamTrajectory(trajectory, rate, playbackDelay=10000, interpolation=STREAM_CUBIC):
+    # trajectory(t) gives the angles of the arm t seconds into the stream, or None once it has finished.
+    # The setpoints are sent in real time, the playback delay has to cover the jitter of the link and the batching.
+    link.send([streamRecord(playbackDelay, interpolation)])
+    start = time()
+    index = 0
+    batch = []
+    while True:
+        angles = trajectory(index / rate)
+        isEnd = angles is None
+        if isEnd:
+            angles = trajectory((index - 1) / rate)
+        batch.append(setpointRecord(int(index * 1e6 / rate), angles, isEnd))
+        if isEnd or len(batch) >= STREAM_BATCH_SETPOINTS:
+            link.send(batch)
+            batch = []
+        if isEnd:
+            break
+        index += 1
+        while time() - start < index / rate:
+            link.pump()
+
+BENCHMARK_FRAME_INTERVAL = 0.002 # Time between the frames sent during the serial load benchmark (seconds)
+
+def runBenchmarks():
+    # The Teensy has to be built with [env:teensy41_bench], the results are printed as they arrive. Between the
+    # "serial_load_start" and "serial_load_stop" lines frames are sent with a movement to the end of the benchmark
+    # move (while there are credits for it) and a queue status request, so the Teensy decodes, checks and answers
+    # real frames while it steps
+    benchmark = {"load": None, "finished": False}
+    def handleLine(line):
+        if line.startswith("Queue Status: "):
+            # Replies to the load frames
+            return True
+        if not line.startswith("{"):
+            return False
+        print(line)
+        result = json.loads(line)
+        if result["benchmark"] == "serial_load_start":
+            benchmark["load"] = result
+        elif result["benchmark"] == "serial_load_stop":
+            benchmark["load"] = None
+        elif result["benchmark"] == "summary":
+            benchmark["finished"] = True
+        return True
+    link.lineHandler = handleLine
+    nextFrame = time()
+    while not benchmark["finished"]:
+        link.pump()
+        load = benchmark["load"]
+        if load is not None and time() >= nextFrame and not link.waiting and len(link.unanswered) < WINDOW_FRAMES:
+            records = []
+            if link.credits - sum(frame[2] for frame in link.unanswered) > 0:
+                records.append(movementRecord(load["target_deg"], load["velocity"], load["acceleration"]))
+            records.append(struct.pack("<B", QUEUE_STATUS_REQUEST))
+            link.send(records)
+            nextFrame = time() + BENCHMARK_FRAME_INTERVAL
+        sleep(0.0005)
+    link.lineHandler = None
+
+if __name__ == "__main__":
+    # The module can also be imported (see Control-Hub-V2/test/host), only running it as a script moves the arm
+    #runBenchmarks()
+    #goHome()
+    goHome()
+
+    for num in range(1):
+        #sendMovement1(250, 36 + 90, 120, 142.5, 180)
+        sendMovement1(170, 150, 60 + 180, 142.5, 180)
+        sendMovement1(80, 50, 180, 142.5, 180)
+        sendMovement1(80, 110, 90, 142.5, 180)
     
-goHome()
-"""
-#sendMovement1(180, 130, 45, 180, 180)
+    goHome()
+    """
+    #sendMovement1(180, 130, 45, 180, 180)
 
-sendMovement1(300, 130, 45, 105, 225)
-sendMovement1(135, 130, 45, 225, 145)
-sendMovement1(180, 130, 45, 180, 180)
+    sendMovement1(300, 130, 45, 105, 225)
+    sendMovement1(135, 130, 45, 225, 145)
+    sendMovement1(180, 130, 45, 180, 180)
 
-sendMovement1(180, 130, 225, 180, 180)
+    sendMovement1(180, 130, 225, 180, 180)
 
-sendMovement1(300, 130, 225, 225, 225)
-sendMovement1(135, 130, 225, 105, 145)
-sendMovement1(180, 130, 225, 180, 180)
+    sendMovement1(300, 130, 225, 225, 225)
+    sendMovement1(135, 130, 225, 105, 145)
+    sendMovement1(180, 130, 225, 180, 180)
 
-sendMovement1(225, 45, 90, 135, 180)
-sendMovement1(135, 130, 45, 180, 180)
-"""
+    sendMovement1(225, 45, 90, 135, 180)
+    sendMovement1(135, 130, 45, 180, 180)
+    """
 
 
 
 
 
-"""
-data = ""
-while data != "quit":
+    """
+    data = ""
+    while data != "quit":
 
-    data = input("Command: ")
-    if (data == "test"):
-        while ser.inWaiting() > 0:
-            dataRecived = ser.read_until(b"\n")
-            print("Teensy: " + dataRecived.decode("ascii")[:-2])
+        data = input("Command: ")
+        if (data == "test"):
+            while ser.inWaiting() > 0:
+                dataRecived = ser.read_until(b"\n")
+                print("Teensy: " + dataRecived.decode("ascii")[:-2])
 
-        sendMovement1()
-    elif (data != "quit"):
-        print(struct.pack("d", float(data)))
-        ser.write(struct.pack("d", float(data)))
-        dataRecived = ser.read_until(b"\n")
-        print("Teensy: " + dataRecived.decode("ascii")[:-2])
-        dataRecived = ser.read_until(b"\n")
-        print("Teensy: " + dataRecived.decode("ascii")[:-2])
-"""
-print("Goodbye!")
-ser.close()
+            sendMovement1()
+        elif (data != "quit"):
+            requestQueueStatus()
+    """
+    link.flush()
+    print("Goodbye!")
+    ser.close()